@@ -0,0 +1,346 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+// Throughput and latency percentiles of the contact storage operations at several
+// scales (1k, 10k and 100k contacts by default, or the scales given as arguments):
+// addContact, getContact, getAllContacts, getCollectEndorse, getDnsData, and the
+// endorsement counting done by ContactManager::prepareEndorseInfo.  Runs in a temporary
+// $HOME, so neither the user's contacts nor the user's KeyChain are touched.
+
+#include "contact-storage.hpp"
+#include "endorse-certificate.hpp"
+#include "trust-scope-index.hpp"
+#include <ndn-cxx/security/key-chain.hpp>
+#include <ndn-cxx/security/validator.hpp>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+using namespace chronochat;
+
+using std::string;
+using std::vector;
+
+namespace fs = boost::filesystem;
+
+static const size_t N_LOOKUPS = 10000;
+static const size_t N_SCANS = 5;
+static const size_t N_ENDORSERS = 16;
+
+static const Name BENCH_PREFIX("/bench/contact-storage");
+
+class Samples
+{
+public:
+  void
+  add(const time::steady_clock::TimePoint& start)
+  {
+    m_samples.push_back(time::duration_cast<time::nanoseconds>(time::steady_clock::now() -
+                                                                 start).count());
+  }
+
+  void
+  report(size_t scale, const string& operation)
+  {
+    if (m_samples.empty())
+      return;
+
+    std::sort(m_samples.begin(), m_samples.end());
+    double total = 0;
+    for (vector<int64_t>::const_iterator it = m_samples.begin(); it != m_samples.end(); it++)
+      total += *it;
+
+    std::cout << std::setw(8) << scale << "  "
+              << std::setw(20) << std::left << operation << std::right
+              << std::setw(8) << m_samples.size()
+              << std::setw(12) << std::fixed << std::setprecision(0)
+              << m_samples.size() / (total / 1e9)
+              << std::setprecision(1)
+              << std::setw(10) << getPercentile(0.50)
+              << std::setw(10) << getPercentile(0.90)
+              << std::setw(10) << getPercentile(0.99)
+              << std::setw(10) << m_samples.back() / 1000.0
+              << std::endl;
+  }
+
+private:
+  /// @return the @p p quantile in microseconds
+  double
+  getPercentile(double p) const
+  {
+    size_t index = std::min(m_samples.size() - 1, static_cast<size_t>(p * m_samples.size()));
+    return m_samples[index] / 1000.0;
+  }
+
+private:
+  vector<int64_t> m_samples;
+};
+
+static Name
+getContactName(size_t i)
+{
+  return Name(BENCH_PREFIX).append("user" + std::to_string(i));
+}
+
+static Profile
+makeProfile(const Name& identity)
+{
+  Profile profile;
+  profile["IDENTITY"] = identity.toUri();
+  profile["name"] = identity.get(-1).toUri();
+  profile["institution"] = "Bench University";
+  profile["email"] = identity.get(-1).toUri() + "@bench.edu";
+  return profile;
+}
+
+/// @brief The introducers who sign the endorsement certificates of the target identity
+struct Endorsers
+{
+  vector<shared_ptr<Contact> > contacts;
+  shared_ptr<ndn::IdentityCertificate> targetCertificate;
+  Profile targetProfile;
+  vector<shared_ptr<EndorseCertificate> > certificates;
+};
+
+static Endorsers
+makeEndorsers(ndn::KeyChain& keyChain)
+{
+  Endorsers endorsers;
+
+  Name target = Name(BENCH_PREFIX).append("target");
+  endorsers.targetCertificate =
+    keyChain.getCertificate(keyChain.createIdentity(target));
+  endorsers.targetProfile = makeProfile(target);
+
+  vector<string> endorseList;
+  for (Profile::const_iterator it = endorsers.targetProfile.begin();
+       it != endorsers.targetProfile.end(); it++)
+    endorseList.push_back(it->first);
+
+  EndorseCertificate selfEndorseCertificate(*endorsers.targetCertificate,
+                                            endorsers.targetProfile, endorseList);
+
+  for (size_t i = 0; i < N_ENDORSERS; i++) {
+    Name identity = Name(BENCH_PREFIX).append("endorser" + std::to_string(i));
+    Name certName = keyChain.createIdentity(identity);
+    shared_ptr<ndn::IdentityCertificate> cert = keyChain.getCertificate(certName);
+
+    shared_ptr<Contact> contact =
+      make_shared<Contact>(identity, "endorser", cert->getPublicKeyName(),
+                           cert->getNotBefore(), cert->getNotAfter(),
+                           cert->getPublicKeyInfo(), true);
+    contact->setProfile(makeProfile(identity));
+    contact->addTrustScope(BENCH_PREFIX);
+    endorsers.contacts.push_back(contact);
+
+    shared_ptr<EndorseCertificate> endorseCertificate =
+      make_shared<EndorseCertificate>(selfEndorseCertificate, cert->getPublicKeyName(),
+                                      endorseList);
+    keyChain.sign(*endorseCertificate, certName);
+    endorsers.certificates.push_back(endorseCertificate);
+  }
+
+  return endorsers;
+}
+
+/// @brief The endorsement counting of ContactManager::prepareEndorseInfo
+static size_t
+countEndorsements(const std::map<Name, shared_ptr<Contact> >& contacts,
+                  const TrustScopeIndex& trustScopes,
+                  const Profile& profile,
+                  const vector<shared_ptr<EndorseCertificate> >& certificates)
+{
+  TrustScopeIndex::Introducers introducers =
+    trustScopes.findIntroducers(profile.getIdentityName());
+
+  std::map<string, size_t> endorseCount;
+  for (vector<shared_ptr<EndorseCertificate> >::const_iterator cIt = certificates.begin();
+       cIt != certificates.end(); cIt++) {
+    Name signer = (*cIt)->getSigner().getPrefix(-1);
+    if (introducers.count(signer) == 0)
+      continue;
+
+    std::map<Name, shared_ptr<Contact> >::const_iterator contact = contacts.find(signer);
+    if (contact == contacts.end())
+      continue;
+
+    if (!ndn::Validator::verifySignature(**cIt, contact->second->getPublicKey()))
+      continue;
+
+    if ((*cIt)->getProfile() != profile)
+      continue;
+
+    const vector<string>& endorseList = (*cIt)->getEndorseList();
+    for (vector<string>::const_iterator eIt = endorseList.begin(); eIt != endorseList.end(); eIt++)
+      endorseCount[*eIt] += 1;
+  }
+
+  return endorseCount.size();
+}
+
+static void
+runScale(size_t scale, ndn::KeyChain& keyChain, const Endorsers& endorsers)
+{
+  ContactStorage storage(Name(BENCH_PREFIX).append("owner" + std::to_string(scale)));
+  std::mt19937 random(scale);
+  const ndn::PublicKey& key = endorsers.targetCertificate->getPublicKeyInfo();
+
+  {
+    Samples samples;
+    for (size_t i = 0; i < scale; i++) {
+      Name identity = getContactName(i);
+      Contact contact(identity, "alias" + std::to_string(i), Name(identity).append("ksk-1"),
+                      time::system_clock::now(), time::system_clock::now() + time::days(365),
+                      key, i % 10 == 0);
+      contact.setProfile(makeProfile(identity));
+      contact.addTrustScope(identity);
+
+      time::steady_clock::TimePoint start = time::steady_clock::now();
+      storage.addContact(contact);
+      samples.add(start);
+    }
+    for (size_t i = 0; i < endorsers.contacts.size(); i++)
+      storage.addContact(*endorsers.contacts[i]);
+    samples.report(scale, "addContact");
+  }
+
+  {
+    Samples samples;
+    for (size_t i = 0; i < N_LOOKUPS; i++) {
+      Name identity = getContactName(random() % scale);
+      time::steady_clock::TimePoint start = time::steady_clock::now();
+      storage.getContact(identity);
+      samples.add(start);
+    }
+    samples.report(scale, "getContact");
+  }
+
+  std::map<Name, shared_ptr<Contact> > contactIndex;
+  TrustScopeIndex trustScopes;
+  {
+    Samples samples;
+    for (size_t i = 0; i < N_SCANS; i++) {
+      vector<shared_ptr<Contact> > contacts;
+      time::steady_clock::TimePoint start = time::steady_clock::now();
+      storage.getAllContacts(contacts);
+      samples.add(start);
+
+      if (i == 0)
+        for (size_t j = 0; j < contacts.size(); j++) {
+          contactIndex[contacts[j]->getNameSpace()] = contacts[j];
+          trustScopes.insert(*contacts[j]);
+        }
+    }
+    samples.report(scale, "getAllContacts");
+  }
+
+  {
+    vector<shared_ptr<EndorseCertificate> > collected;
+    for (size_t i = 0; i < scale; i++) {
+      Name identity = getContactName(i);
+      shared_ptr<EndorseCertificate> certificate =
+        make_shared<EndorseCertificate>(Name(BENCH_PREFIX).append("KEY").append("ksk-1"), key,
+                                        time::system_clock::now(),
+                                        time::system_clock::now() + time::days(365),
+                                        Name(identity).append("ksk-1"),
+                                        endorsers.targetProfile, vector<string>());
+      keyChain.signWithSha256(*certificate);
+      collected.push_back(certificate);
+    }
+    storage.updateCollectEndorse(collected);
+
+    Samples samples;
+    for (size_t i = 0; i < N_SCANS; i++) {
+      EndorseCollection collection;
+      time::steady_clock::TimePoint start = time::steady_clock::now();
+      storage.getCollectEndorse(collection);
+      samples.add(start);
+    }
+    samples.report(scale, "getCollectEndorse");
+  }
+
+  {
+    for (size_t i = 0; i < scale; i++) {
+      Name identity = getContactName(i);
+      Data data(Name(BENCH_PREFIX).append("DNS").append(identity.wireEncode())
+                .append("ENDORSEE").appendVersion());
+      data.setContent(Block(tlv::Content));
+      keyChain.signWithSha256(data);
+      storage.updateDnsEndorseOthers(data, identity.toUri());
+    }
+
+    Samples samples;
+    for (size_t i = 0; i < N_LOOKUPS; i++) {
+      string endorsee = getContactName(random() % scale).toUri();
+      time::steady_clock::TimePoint start = time::steady_clock::now();
+      storage.getDnsData(endorsee, "ENDORSEE");
+      samples.add(start);
+    }
+    samples.report(scale, "getDnsData");
+  }
+
+  {
+    // every contact endorses the target; the certificates of the few real signers are
+    // repeated, which costs the same to verify as distinct ones
+    vector<shared_ptr<EndorseCertificate> > certificates;
+    for (size_t i = 0; i < scale; i++)
+      certificates.push_back(endorsers.certificates[i % endorsers.certificates.size()]);
+
+    Samples samples;
+    for (size_t i = 0; i < N_SCANS; i++) {
+      time::steady_clock::TimePoint start = time::steady_clock::now();
+      if (countEndorsements(contactIndex, trustScopes, endorsers.targetProfile,
+                            certificates) == 0)
+        std::cerr << "prepareEndorseInfo: no endorsement was counted" << std::endl;
+      samples.add(start);
+    }
+    samples.report(scale, "prepareEndorseInfo");
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  vector<size_t> scales;
+  for (int i = 1; i < argc; i++)
+    scales.push_back(std::strtoul(argv[i], 0, 10));
+  if (scales.empty()) {
+    scales.push_back(1000);
+    scales.push_back(10000);
+    scales.push_back(100000);
+  }
+
+  fs::path home = fs::temp_directory_path() / fs::unique_path("chronochat-bench-%%%%%%%%");
+  fs::create_directories(home);
+  setenv("HOME", home.c_str(), 1);
+
+  {
+    ndn::KeyChain keyChain;
+    Endorsers endorsers = makeEndorsers(keyChain);
+
+    std::cout << std::setw(8) << "scale" << "  "
+              << std::setw(20) << std::left << "operation" << std::right
+              << std::setw(8) << "ops"
+              << std::setw(12) << "ops/s"
+              << std::setw(10) << "p50(us)"
+              << std::setw(10) << "p90(us)"
+              << std::setw(10) << "p99(us)"
+              << std::setw(10) << "max(us)"
+              << std::endl;
+
+    for (vector<size_t>::const_iterator it = scales.begin(); it != scales.end(); it++)
+      runScale(*it, keyChain, endorsers);
+  }
+
+  fs::remove_all(home);
+  return 0;
+}
@@ -0,0 +1,215 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+// Per-lookup cost of ContactStorage::getContact and ContactStorage::getDnsData with the
+// prepared-statement cache, compared against preparing and finalizing the same SQL on
+// every call.  Runs in a temporary $HOME.
+
+#include "contact-storage.hpp"
+#include <ndn-cxx/security/key-chain.hpp>
+#include <boost/filesystem.hpp>
+#include <iostream>
+
+using namespace chronochat;
+
+namespace fs = boost::filesystem;
+
+static const size_t N_ENTRIES = 1000;
+static const size_t N_LOOKUPS = 20000;
+
+static double
+elapsedUs(const time::steady_clock::TimePoint& start, size_t nOps)
+{
+  time::nanoseconds elapsed = time::steady_clock::now() - start;
+  return elapsed.count() / 1000.0 / nOps;
+}
+
+static Name
+getEntryName(size_t i)
+{
+  return Name("/bench/statement-cache").append("user" + std::to_string(i));
+}
+
+static sqlite3_stmt*
+prepare(sqlite3* db, const char* sql)
+{
+  sqlite3_stmt* stmt;
+  if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK)
+    throw std::runtime_error("Cannot prepare statement: " + std::string(sqlite3_errmsg(db)));
+  return stmt;
+}
+
+/// @return true if @p stmt produced a row, false if it is done
+static bool
+step(sqlite3* db, sqlite3_stmt* stmt)
+{
+  int res = sqlite3_step(stmt);
+  if (res != SQLITE_ROW && res != SQLITE_DONE) {
+    sqlite3_finalize(stmt);
+    throw std::runtime_error("Cannot step statement: " + std::string(sqlite3_errmsg(db)));
+  }
+  return res == SQLITE_ROW;
+}
+
+static std::string
+getColumnString(sqlite3_stmt* stmt, int column)
+{
+  return std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, column)),
+                     sqlite3_column_bytes(stmt, column));
+}
+
+static shared_ptr<Data>
+uncachedGetDnsData(sqlite3* db, const std::string& name, const std::string& type)
+{
+  shared_ptr<Data> data;
+
+  sqlite3_stmt* stmt = prepare(db, "SELECT dns_value FROM DnsData where dns_name=? and dns_type=?");
+  sqlite3_bind_text(stmt, 1, name.c_str(), name.size(), SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, 2, type.c_str(), type.size(), SQLITE_TRANSIENT);
+
+  if (step(db, stmt)) {
+    data = make_shared<Data>();
+    data->wireDecode(Block(reinterpret_cast<const char*>(sqlite3_column_blob(stmt, 0)),
+                           sqlite3_column_bytes(stmt, 0)));
+  }
+  sqlite3_finalize(stmt);
+
+  return data;
+}
+
+/// @brief ContactStorage::getContact, with its statements prepared per call
+static shared_ptr<Contact>
+uncachedGetContact(sqlite3* db, const Name& identity)
+{
+  shared_ptr<Contact> contact;
+  Profile profile;
+  std::string identityUri = identity.toUri();
+
+  sqlite3_stmt* stmt = prepare(db,
+                               "SELECT contact_alias, contact_keyName, contact_key, notBefore, \
+                                notAfter, is_introducer FROM Contact where contact_namespace=?");
+  sqlite3_bind_text(stmt, 1, identityUri.c_str(), identityUri.size(), SQLITE_TRANSIENT);
+  if (step(db, stmt)) {
+    std::string alias = getColumnString(stmt, 0);
+    std::string keyName = getColumnString(stmt, 1);
+    ndn::PublicKey key(sqlite3_column_text(stmt, 2), sqlite3_column_bytes(stmt, 2));
+    time::system_clock::TimePoint notBefore =
+      time::fromUnixTimestamp(time::milliseconds(sqlite3_column_int64(stmt, 3)));
+    time::system_clock::TimePoint notAfter =
+      time::fromUnixTimestamp(time::milliseconds(sqlite3_column_int64(stmt, 4)));
+    int isIntroducer = sqlite3_column_int(stmt, 5);
+
+    contact = make_shared<Contact>(identity, alias, Name(keyName),
+                                   notBefore, notAfter, key, isIntroducer);
+  }
+  sqlite3_finalize(stmt);
+
+  stmt = prepare(db, "SELECT profile_type, profile_value FROM ContactProfile \
+                      where profile_identity=?");
+  sqlite3_bind_text(stmt, 1, identityUri.c_str(), identityUri.size(), SQLITE_TRANSIENT);
+  while (step(db, stmt))
+    profile[getColumnString(stmt, 0)] = getColumnString(stmt, 1);
+  sqlite3_finalize(stmt);
+
+  if (!static_cast<bool>(contact))
+    return contact;
+
+  contact->setProfile(profile);
+
+  if (contact->isIntroducer()) {
+    stmt = prepare(db, "SELECT trust_scope FROM TrustScope WHERE contact_namespace=?");
+    sqlite3_bind_text(stmt, 1, identityUri.c_str(), identityUri.size(), SQLITE_TRANSIENT);
+    while (step(db, stmt))
+      contact->addTrustScope(Name(getColumnString(stmt, 0)));
+    sqlite3_finalize(stmt);
+  }
+
+  return contact;
+}
+
+/// @return the database of the storage, not its -wal or -shm file
+static fs::path
+findDatabase(const fs::path& directory)
+{
+  for (fs::directory_iterator it(directory); it != fs::directory_iterator(); it++) {
+    std::string fileName = it->path().filename().string();
+    if (fileName.compare(0, 8, "chronos-") == 0 && it->path().extension() == ".db")
+      return it->path();
+  }
+  throw std::runtime_error("No contact storage in " + directory.string());
+}
+
+int
+main()
+{
+  fs::path home = fs::temp_directory_path() / fs::unique_path("chronochat-bench-%%%%%%%%");
+  fs::create_directories(home);
+  setenv("HOME", home.c_str(), 1);
+
+  int status = 0;
+  try {
+    ndn::KeyChain keyChain;
+    Name certName = keyChain.createIdentity(Name("/bench/statement-cache"));
+    ndn::PublicKey key = keyChain.getCertificate(certName)->getPublicKeyInfo();
+
+    ContactStorage storage(Name("/bench/statement-cache"));
+    for (size_t i = 0; i < N_ENTRIES; i++) {
+      Name identity = getEntryName(i);
+      Contact contact(identity, "alias", Name(identity).append("ksk-1"),
+                      time::system_clock::now(), time::system_clock::now() + time::days(365),
+                      key, false);
+      storage.addContact(contact);
+
+      Data data(Name(identity).append("DNS").append("ENDORSEE").appendVersion());
+      data.setContent(Block(tlv::Content));
+      keyChain.signWithSha256(data);
+      storage.updateDnsEndorseOthers(data, identity.toUri());
+    }
+
+    fs::path dbPath = findDatabase(home / ".chronos");
+
+    sqlite3* db;
+    if (sqlite3_open(dbPath.c_str(), &db) != SQLITE_OK)
+      throw std::runtime_error("Cannot open " + dbPath.string());
+
+    time::steady_clock::TimePoint start = time::steady_clock::now();
+    for (size_t i = 0; i < N_LOOKUPS; i++)
+      uncachedGetDnsData(db, getEntryName(i % N_ENTRIES).toUri(), "ENDORSEE");
+    double uncachedDns = elapsedUs(start, N_LOOKUPS);
+
+    start = time::steady_clock::now();
+    for (size_t i = 0; i < N_LOOKUPS; i++)
+      storage.getDnsData(getEntryName(i % N_ENTRIES).toUri(), "ENDORSEE");
+    double cachedDns = elapsedUs(start, N_LOOKUPS);
+
+    start = time::steady_clock::now();
+    for (size_t i = 0; i < N_LOOKUPS; i++)
+      uncachedGetContact(db, getEntryName(i % N_ENTRIES));
+    double uncachedContact = elapsedUs(start, N_LOOKUPS);
+
+    start = time::steady_clock::now();
+    for (size_t i = 0; i < N_LOOKUPS; i++)
+      storage.getContact(getEntryName(i % N_ENTRIES));
+    double cachedContact = elapsedUs(start, N_LOOKUPS);
+
+    sqlite3_close(db);
+
+    std::cout << "getDnsData: " << uncachedDns << " us/lookup prepared per call, "
+              << cachedDns << " us/lookup cached" << std::endl;
+    std::cout << "getContact: " << uncachedContact << " us/lookup prepared per call, "
+              << cachedContact << " us/lookup cached" << std::endl;
+  }
+  catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    status = 1;
+  }
+
+  fs::remove_all(home);
+  return status;
+}
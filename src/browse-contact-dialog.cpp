@@ -105,6 +105,18 @@ BrowseContactDialog::onNameListReady(const QStringList& qNameList)
   m_contactListModel->setStringList(m_contactNameList);
 }
 
+void
+BrowseContactDialog::onIdCertAdded(const QString& certName, const QString& name)
+{
+  m_contactCertNameList << certName;
+  m_contactNameList << name;
+
+  // append a row rather than resetting the model, which would lose the selection
+  int row = m_contactListModel->rowCount();
+  m_contactListModel->insertRows(row, 1);
+  m_contactListModel->setData(m_contactListModel->index(row), name);
+}
+
 void
 BrowseContactDialog::onIdCertReady(const IdentityCertificate& idCert)
 {
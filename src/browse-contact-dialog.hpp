@@ -60,6 +60,9 @@ public slots:
   void
   onNameListReady(const QStringList& nameList);
 
+  void
+  onIdCertAdded(const QString& certName, const QString& name);
+
   void
   onIdCertReady(const ndn::IdentityCertificate& idCert);
 
@@ -0,0 +1,310 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#include "cert-directory-fetcher.hpp"
+
+namespace chronochat {
+
+using std::string;
+using boost::asio::ip::tcp;
+
+const string CertDirectoryFetcher::DEFAULT_HOST("ndncert.named-data.net");
+const string CertDirectoryFetcher::DEFAULT_PORT("80");
+const string CertDirectoryFetcher::DEFAULT_PATH("/cert/list/");
+const boost::posix_time::time_duration CertDirectoryFetcher::DEFAULT_TIMEOUT =
+  boost::posix_time::milliseconds(5000);
+
+/**
+ * @brief One HTTP exchange with the directory
+ *
+ * Every pending asynchronous operation holds a reference to the session, so it lives
+ * until the last handler has run, even after the fetcher has moved on or is destroyed.
+ */
+class CertDirectoryFetcher::Session : public enable_shared_from_this<Session>
+{
+public:
+  Session(boost::asio::io_service& ioService,
+          const string& host, const string& port, const string& path,
+          const boost::posix_time::time_duration& timeout,
+          const OnCertName& onCertName, const OnDone& onDone, const OnFailure& onFailure)
+    : m_resolver(ioService)
+    , m_socket(ioService)
+    , m_timer(ioService)
+    , m_host(host)
+    , m_port(port)
+    , m_path(path)
+    , m_timeout(timeout)
+    , m_onCertName(onCertName)
+    , m_onDone(onDone)
+    , m_onFailure(onFailure)
+    , m_isFinished(false)
+  {
+  }
+
+  void
+  start()
+  {
+    restartTimer();
+    m_resolver.async_resolve(tcp::resolver::query(m_host, m_port),
+                             bind(&Session::onResolved, shared_from_this(), _1, _2));
+  }
+
+  void
+  cancel()
+  {
+    m_onCertName = OnCertName();
+    m_onDone = OnDone();
+    m_onFailure = OnFailure();
+    finish(string());
+  }
+
+private:
+  void
+  restartTimer()
+  {
+    m_timer.expires_from_now(m_timeout);
+    m_timer.async_wait(bind(&Session::onTimeout, shared_from_this(), _1));
+  }
+
+  void
+  onTimeout(const boost::system::error_code& error)
+  {
+    if (error == boost::asio::error::operation_aborted || m_isFinished)
+      return;
+    finish("Certificate directory timed out");
+  }
+
+  void
+  onResolved(const boost::system::error_code& error, tcp::resolver::iterator endpoints)
+  {
+    if (m_isFinished)
+      return;
+    if (error) {
+      finish("Cannot resolve certificate directory: " + error.message());
+      return;
+    }
+
+    boost::asio::async_connect(m_socket, endpoints,
+                               bind(&Session::onConnected, shared_from_this(), _1));
+  }
+
+  void
+  onConnected(const boost::system::error_code& error)
+  {
+    if (m_isFinished)
+      return;
+    if (error) {
+      finish("Cannot connect to certificate directory: " + error.message());
+      return;
+    }
+
+    m_request = "GET " + m_path + " HTTP/1.0\r\n" + "Host: " + m_host + "\r\n\r\n";
+    boost::asio::async_write(m_socket, boost::asio::buffer(m_request),
+                             bind(&Session::onRequestSent, shared_from_this(), _1));
+  }
+
+  void
+  onRequestSent(const boost::system::error_code& error)
+  {
+    if (m_isFinished)
+      return;
+    if (error) {
+      finish("Cannot send request to certificate directory: " + error.message());
+      return;
+    }
+
+    boost::asio::async_read_until(m_socket, m_response, "\r\n\r\n",
+                                  bind(&Session::onHeaders, shared_from_this(), _1));
+  }
+
+  void
+  onHeaders(const boost::system::error_code& error)
+  {
+    if (m_isFinished)
+      return;
+    if (error) {
+      finish("Cannot read response of certificate directory: " + error.message());
+      return;
+    }
+
+    std::istream response(&m_response);
+    string httpVersion;
+    size_t statusCode = 0;
+    response >> httpVersion >> statusCode;
+    string statusMessage;
+    std::getline(response, statusMessage);
+
+    if (!response || httpVersion.substr(0, 5) != "HTTP/") {
+      finish("Malformed response of certificate directory");
+      return;
+    }
+    if (statusCode != 200) {
+      finish("Certificate directory answered with status " +
+             boost::lexical_cast<string>(statusCode));
+      return;
+    }
+
+    string header;
+    while (std::getline(response, header) && header != "\r")
+      ;
+
+    // the rest of the buffer is already part of the body
+    parseBody();
+    readBody();
+  }
+
+  void
+  readBody()
+  {
+    restartTimer();
+    boost::asio::async_read(m_socket, m_response, boost::asio::transfer_at_least(1),
+                            bind(&Session::onBody, shared_from_this(), _1));
+  }
+
+  void
+  onBody(const boost::system::error_code& error)
+  {
+    if (m_isFinished)
+      return;
+
+    parseBody();
+
+    if (error == boost::asio::error::eof) {
+      parseLine(m_partialLine);
+      m_partialLine.clear();
+      finish(string());
+    }
+    else if (error)
+      finish("Cannot read certificate list: " + error.message());
+    else
+      readBody();
+  }
+
+  /// @brief Report the complete lines received so far
+  void
+  parseBody()
+  {
+    const char* begin = boost::asio::buffer_cast<const char*>(m_response.data());
+    m_partialLine.append(begin, m_response.size());
+    m_response.consume(m_response.size());
+
+    size_t lineStart = 0;
+    size_t lineEnd;
+    while (!m_isFinished && (lineEnd = m_partialLine.find('\n', lineStart)) != string::npos) {
+      parseLine(m_partialLine.substr(lineStart, lineEnd - lineStart));
+      lineStart = lineEnd + 1;
+    }
+    m_partialLine.erase(0, lineStart);
+  }
+
+  void
+  parseLine(const string& line)
+  {
+    string certName = boost::algorithm::trim_copy(line);
+    if (certName.size() >= 2 && certName[0] == '"' && certName[certName.size() - 1] == '"')
+      certName = certName.substr(1, certName.size() - 2);
+
+    if (!certName.empty() && m_onCertName)
+      m_onCertName(certName);
+  }
+
+  /// @brief Stop all pending operations and report the outcome, empty on success
+  void
+  finish(const string& failInfo)
+  {
+    if (m_isFinished)
+      return;
+    m_isFinished = true;
+
+    boost::system::error_code error;
+    m_timer.cancel(error);
+    m_resolver.cancel();
+    m_socket.close(error);
+
+    if (failInfo.empty()) {
+      if (m_onDone)
+        m_onDone();
+    }
+    else if (m_onFailure)
+      m_onFailure(failInfo);
+  }
+
+private:
+  tcp::resolver m_resolver;
+  tcp::socket m_socket;
+  boost::asio::deadline_timer m_timer;
+
+  string m_host;
+  string m_port;
+  string m_path;
+  boost::posix_time::time_duration m_timeout;
+
+  OnCertName m_onCertName;
+  OnDone m_onDone;
+  OnFailure m_onFailure;
+
+  string m_request;
+  boost::asio::streambuf m_response;
+  string m_partialLine;
+  bool m_isFinished;
+};
+
+CertDirectoryFetcher::CertDirectoryFetcher(boost::asio::io_service& ioService,
+                                           const string& host,
+                                           const string& port,
+                                           const string& path)
+  : m_ioService(ioService)
+  , m_host(host)
+  , m_port(port)
+  , m_path(path)
+  , m_timeout(DEFAULT_TIMEOUT)
+{
+}
+
+CertDirectoryFetcher::~CertDirectoryFetcher()
+{
+  cancel();
+}
+
+void
+CertDirectoryFetcher::setEndpoint(const string& host, const string& port, const string& path)
+{
+  m_host = host;
+  m_port = port;
+  m_path = path;
+}
+
+void
+CertDirectoryFetcher::setTimeout(const boost::posix_time::time_duration& timeout)
+{
+  m_timeout = timeout;
+}
+
+void
+CertDirectoryFetcher::fetch(const OnCertName& onCertName,
+                            const OnDone& onDone, const OnFailure& onFailure)
+{
+  cancel();
+
+  m_session = make_shared<Session>(m_ioService, m_host, m_port, m_path, m_timeout,
+                                   onCertName, onDone, onFailure);
+  m_session->start();
+}
+
+void
+CertDirectoryFetcher::cancel()
+{
+  if (static_cast<bool>(m_session)) {
+    m_session->cancel();
+    m_session.reset();
+  }
+}
+
+} // namespace chronochat
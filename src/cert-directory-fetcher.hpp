@@ -0,0 +1,80 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#ifndef CHRONOCHAT_CERT_DIRECTORY_FETCHER_HPP
+#define CHRONOCHAT_CERT_DIRECTORY_FETCHER_HPP
+
+#include "common.hpp"
+
+namespace chronochat {
+
+/**
+ * @brief Fetches the list of certificate names from a certificate directory over HTTP
+ *
+ * The request runs asynchronously on @p ioService.  The response body is parsed as it
+ * arrives, one certificate name per line, so names are reported before the whole list
+ * has been received.  The fetch fails if the directory is silent for longer than the
+ * timeout.
+ */
+class CertDirectoryFetcher : noncopyable
+{
+public:
+  typedef function<void(const std::string& certName)> OnCertName;
+  typedef function<void()> OnDone;
+  typedef function<void(const std::string& failInfo)> OnFailure;
+
+  static const std::string DEFAULT_HOST;
+  static const std::string DEFAULT_PORT;
+  static const std::string DEFAULT_PATH;
+  static const boost::posix_time::time_duration DEFAULT_TIMEOUT;
+
+  explicit
+  CertDirectoryFetcher(boost::asio::io_service& ioService,
+                       const std::string& host = DEFAULT_HOST,
+                       const std::string& port = DEFAULT_PORT,
+                       const std::string& path = DEFAULT_PATH);
+
+  ~CertDirectoryFetcher();
+
+  /// @brief Set the directory used by the following fetches
+  void
+  setEndpoint(const std::string& host, const std::string& port, const std::string& path);
+
+  void
+  setTimeout(const boost::posix_time::time_duration& timeout);
+
+  /**
+   * @brief Fetch the certificate list, cancelling a fetch still in progress
+   *
+   * @p onCertName is called for each name in the list, then either @p onDone or
+   * @p onFailure is called once.
+   */
+  void
+  fetch(const OnCertName& onCertName, const OnDone& onDone, const OnFailure& onFailure);
+
+  /// @brief Stop the fetch in progress without calling any of its callbacks
+  void
+  cancel();
+
+private:
+  class Session;
+
+  boost::asio::io_service& m_ioService;
+  std::string m_host;
+  std::string m_port;
+  std::string m_path;
+  boost::posix_time::time_duration m_timeout;
+
+  shared_ptr<Session> m_session;
+};
+
+} // namespace chronochat
+
+#endif // CHRONOCHAT_CERT_DIRECTORY_FETCHER_HPP
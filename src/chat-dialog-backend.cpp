@@ -11,12 +11,9 @@
 
 #include "chat-dialog-backend.hpp"
 
-#include <QFile>
-
 #ifndef Q_MOC_RUN
-#include <boost/iostreams/stream.hpp>
-#include <ndn-cxx/util/io.hpp>
-#include <ndn-cxx/security/validator-regex.hpp>
+#include "validation-policy.hpp"
+#include "cryptopp.hpp"
 #include "logging.h"
 #endif
 
@@ -31,6 +28,22 @@ static const ndn::Name::Component ROUTING_HINT_SEPARATOR =
   ndn::name::Component::fromEscapedString("%F0%2E");
 static const int IDENTITY_OFFSET = -3;
 static const int CONNECTION_RETRY_TIMER = 3;
+static const size_t PREFETCH_WINDOW = 4;
+static const time::milliseconds PREFETCH_LIFETIME(2000);
+// keys are named ksk-<13-digit timestamp in milliseconds>, so no ksk sorts after this one
+static const Name::Component LAST_KSK_COMPONENT("ksk-9999999999999");
+
+/// @brief The identity owning @p sessionPrefix, without the routing hint
+static Name
+getSessionIdentity(const Name& sessionPrefix)
+{
+  Name identity = sessionPrefix.getPrefix(IDENTITY_OFFSET);
+  for (size_t i = 0; i < identity.size(); i++) {
+    if (identity.get(i) == ROUTING_HINT_SEPARATOR)
+      return identity.getSubName(i + 1);
+  }
+  return identity;
+}
 
 ChatDialogBackend::ChatDialogBackend(const Name& chatroomPrefix,
                                      const Name& userChatPrefix,
@@ -56,6 +69,17 @@ ChatDialogBackend::~ChatDialogBackend()
 {
 }
 
+void
+ChatDialogBackend::prefetchCertificates(const std::vector<Name>& identities)
+{
+  std::lock_guard<std::mutex> lock(m_prefetchMutex);
+  m_pendingPrefetch.insert(m_pendingPrefetch.end(), identities.begin(), identities.end());
+
+  // otherwise initializeSync picks them up
+  if (m_face != nullptr)
+    m_face->getIoService().post(bind(&ChatDialogBackend::prefetchPending, this));
+}
+
 // protected methods:
 void
 ChatDialogBackend::run()
@@ -113,30 +137,26 @@ ChatDialogBackend::initializeSync()
 {
   BOOST_ASSERT(m_sock == nullptr);
 
-  m_face = make_shared<ndn::Face>();
+  {
+    std::lock_guard<std::mutex> lock(m_prefetchMutex);
+    m_face = make_shared<ndn::Face>();
+  }
   m_scheduler = unique_ptr<ndn::Scheduler>(new ndn::Scheduler(m_face->getIoService()));
 
   // initialize validator
-  shared_ptr<ndn::IdentityCertificate> anchor = loadTrustAnchor();
-
-  if (static_cast<bool>(anchor)) {
-    shared_ptr<ndn::ValidatorRegex> validator =
-      make_shared<ndn::ValidatorRegex>(m_face.get()); // TODO: Change to Face*
-    validator->addDataVerificationRule(
-      make_shared<ndn::SecRuleRelative>("^<>*<%F0.>(<>*)$",
-                                        "^([^<KEY>]*)<KEY>(<>*)<ksk-.*><ID-CERT>$",
-                                        ">", "\\1", "\\1\\2", true));
-    validator->addDataVerificationRule(
-      make_shared<ndn::SecRuleRelative>("(<>*)$",
-                                        "^([^<KEY>]*)<KEY>(<>*)<ksk-.*><ID-CERT>$",
-                                        ">", "\\1", "\\1\\2", true));
-    validator->addTrustAnchor(anchor);
-
-    m_validator = validator;
-  }
+  shared_ptr<const ValidationPolicy> policy = ValidationPolicy::getChatPolicy();
+
+  // certificates verified in other rooms or before a reconnect are not fetched again
+  if (static_cast<bool>(policy->getTrustAnchor()))
+    m_validator = policy->makeValidator(*m_face);
   else
     m_validator = shared_ptr<ndn::Validator>();
 
+  // after a reconnect, members are prefetched again as the new session hears from them
+  m_prefetchGroup.reset(new RequestGroup(m_face->getIoService(), PREFETCH_WINDOW));
+  m_prefetchGroup->start(RequestGroup::OnProgress(), RequestGroup::OnDone());
+  m_prefetchedIds.clear();
+  prefetchPending();
 
   // create a new SyncSocket
   m_sock = make_shared<chronosync::Socket>(m_chatroomPrefix,
@@ -157,56 +177,111 @@ ChatDialogBackend::initializeSync()
   }
 }
 
-class IoDeviceSource
+void
+ChatDialogBackend::exitChatroom() {
+  if (m_joined)
+    sendLeave();
+
+  usleep(100000);
+}
+
+void
+ChatDialogBackend::close()
 {
-public:
-  typedef char char_type;
-  typedef boost::iostreams::source_tag category;
+  m_scheduler->cancelAllEvents();
+  m_helloEventId.reset();
+  m_roster.clear();
+  m_prefetchGroup.reset();
+  m_validator.reset();
+  m_sock.reset();
+}
 
-  explicit
-  IoDeviceSource(QIODevice& source)
-    : m_source(source)
+void
+ChatDialogBackend::prefetchPending()
+{
+  std::vector<Name> identities;
   {
+    std::lock_guard<std::mutex> lock(m_prefetchMutex);
+    identities.swap(m_pendingPrefetch);
   }
 
-  std::streamsize
-  read(char* buffer, std::streamsize n)
-  {
-    return m_source.read(buffer, n);
-  }
-private:
-  QIODevice& m_source;
-};
+  for (const auto& identity : identities)
+    prefetchCertificate(identity);
+}
 
-shared_ptr<ndn::IdentityCertificate>
-ChatDialogBackend::loadTrustAnchor()
+void
+ChatDialogBackend::prefetchCertificate(const Name& identity)
 {
-  QFile anchorFile(":/security/anchor.cert");
+  if (m_validator == nullptr || identity.empty() || identity == m_signingId)
+    return;
 
-  if (!anchorFile.open(QIODevice::ReadOnly)) {
-    return {};
-  }
+  if (m_prefetchedIds.find(identity) != m_prefetchedIds.end())
+    return;
+
+  // members seen in other rooms or before a reconnect need no fetching
+  if (ValidationPolicy::getChatPolicy()->getCertificateCache()->hasKskCertificateOf(identity))
+    return;
 
-  boost::iostreams::stream<IoDeviceSource> anchorFileStream(anchorFile);
-  return ndn::io::load<ndn::IdentityCertificate>(anchorFileStream);
+  m_prefetchedIds.insert(identity);
+  m_prefetchGroup->add(bind(&ChatDialogBackend::requestCertificate, this, identity, _1));
 }
 
 void
-ChatDialogBackend::exitChatroom() {
-  if (m_joined)
-    sendLeave();
+ChatDialogBackend::requestCertificate(const Name& identity, const RequestGroup::Completion& done)
+{
+  // the key of a member is not known before its first message, so the latest ksk is asked
+  // for: among the children of <identity>/KEY, the ksk components sort last once those
+  // after any ksk (longer ones included) are excluded
+  ndn::Exclude exclude;
+  exclude.excludeAfter(LAST_KSK_COMPONENT);
+
+  Interest interest(Name(identity).append("KEY"));
+  interest.setExclude(exclude);
+  interest.setChildSelector(1);
+  interest.setInterestLifetime(PREFETCH_LIFETIME);
+
+  m_face->expressInterest(interest,
+                          bind(&ChatDialogBackend::onCertificateData, this, _2, identity, done),
+                          bind(&ChatDialogBackend::onCertificateFailed, this, identity, done));
+}
 
-  usleep(100000);
+void
+ChatDialogBackend::onCertificateData(const Data& data, const Name& identity,
+                                     const RequestGroup::Completion& done)
+{
+  // only a ksk certificate of the member itself, <identity>/KEY/ksk-.../ID-CERT/<version>
+  const Name& name = data.getName();
+  Name keyPrefix = Name(identity).append("KEY");
+  if (name.size() != keyPrefix.size() + 3 || !keyPrefix.isPrefixOf(name) ||
+      name.get(keyPrefix.size()).toUri().compare(0, 4, "ksk-") != 0 ||
+      name.get(-2) != Name::Component("ID-CERT")) {
+    onCertificateFailed(identity, done);
+    return;
+  }
+
+  // validating the certificate caches the certificates above it on the way
+  m_validator->validate(data,
+                        bind(&ChatDialogBackend::onCertificateValidated, this, _1, done),
+                        bind(&ChatDialogBackend::onCertificateFailed, this, identity, done));
 }
 
 void
-ChatDialogBackend::close()
+ChatDialogBackend::onCertificateValidated(const shared_ptr<const Data>& data,
+                                          const RequestGroup::Completion& done)
 {
-  m_scheduler->cancelAllEvents();
-  m_helloEventId.reset();
-  m_roster.clear();
-  m_validator.reset();
-  m_sock.reset();
+  shared_ptr<ndn::IdentityCertificate> certificate =
+    make_shared<ndn::IdentityCertificate>(boost::cref(*data));
+  ValidationPolicy::getChatPolicy()->getCertificateCache()->insertCertificate(certificate);
+  done();
+}
+
+void
+ChatDialogBackend::onCertificateFailed(const Name& identity,
+                                       const RequestGroup::Completion& done)
+{
+  // tried again when the member shows up again
+  m_prefetchedIds.erase(identity);
+  done();
 }
 
 void
@@ -226,6 +301,9 @@ ChatDialogBackend::processSyncUpdate(const std::vector<chronosync::MissingDataIn
     if (m_roster.find(updates[i].session) == m_roster.end()) {
       m_roster[updates[i].session].sessionPrefix = updates[i].session;
       m_roster[updates[i].session].hasNick = false;
+
+      // fetched alongside the first messages, not after them
+      prefetchCertificate(getSessionIdentity(updates[i].session));
     }
 
     // fetch missing chat data
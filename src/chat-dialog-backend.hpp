@@ -17,6 +17,7 @@
 #include "common.hpp"
 #include "chatroom-info.hpp"
 #include "chat-message.hpp"
+#include "request-group.hpp"
 #include <mutex>
 #include <socket.hpp>
 #include <boost/thread.hpp>
@@ -53,6 +54,17 @@ public:
 
   ~ChatDialogBackend();
 
+  /**
+   * @brief Fetch and verify the certificates of @p identities in the background
+   *
+   * May be called from any thread, also before the backend runs.  Verified certificates
+   * go to the certificate cache of the chat policy, so that the first messages of these
+   * members are validated without fetching.  The latest ksk certificate of each member
+   * whose certificate is not cached is fetched, and cached only once it is validated.
+   */
+  void
+  prefetchCertificates(const std::vector<Name>& identities);
+
 protected:
   void
   run();
@@ -61,15 +73,30 @@ private:
   void
   initializeSync();
 
-  shared_ptr<ndn::IdentityCertificate>
-  loadTrustAnchor();
-
   void
   exitChatroom();
 
   void
   close();
 
+  void
+  prefetchPending();
+
+  void
+  prefetchCertificate(const Name& identity);
+
+  void
+  requestCertificate(const Name& identity, const RequestGroup::Completion& done);
+
+  void
+  onCertificateData(const Data& data, const Name& identity, const RequestGroup::Completion& done);
+
+  void
+  onCertificateValidated(const shared_ptr<const Data>& data, const RequestGroup::Completion& done);
+
+  void
+  onCertificateFailed(const Name& identity, const RequestGroup::Completion& done);
+
   void
   processSyncUpdate(const std::vector<chronosync::MissingDataInfo>& updates);
 
@@ -179,8 +206,13 @@ private:
 
   BackendRoster m_roster;                // User roster
 
+  unique_ptr<RequestGroup> m_prefetchGroup;// certificate prefetching
+  std::set<Name> m_prefetchedIds;        // identities prefetched or being prefetched
+  std::vector<Name> m_pendingPrefetch;   // identities to prefetch, guarded by m_prefetchMutex
+
   std::mutex m_resumeMutex;
   std::mutex m_nfdConnectionMutex;
+  std::mutex m_prefetchMutex;
 };
 
 } // namespace chronochat
@@ -24,7 +24,6 @@
 
 #include "digest-tree-scene.hpp"
 #include "trust-tree-scene.hpp"
-#include "trust-tree-node.hpp"
 #include "chat-dialog-backend.hpp"
 
 #include "chatroom-info.hpp"
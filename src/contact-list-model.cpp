@@ -0,0 +1,124 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#include "contact-list-model.hpp"
+
+namespace chronochat {
+
+ContactListModel::ContactListModel(QObject* parent)
+  : QAbstractListModel(parent)
+{
+}
+
+void
+ContactListModel::reset(const QStringList& idList, const QStringList& aliasList)
+{
+  beginResetModel();
+  m_rows.clear();
+  m_index.clear();
+  for (int i = 0; i < idList.size() && i < aliasList.size(); i++) {
+    if (m_index.contains(idList[i]))
+      continue;
+
+    Row row;
+    row.identity = idList[i];
+    row.alias = aliasList[i];
+    m_index.insert(row.identity, m_rows.size());
+    m_rows.append(row);
+  }
+  endResetModel();
+}
+
+void
+ContactListModel::addContact(const QString& identity, const QString& alias)
+{
+  if (m_index.contains(identity)) {
+    setAlias(identity, alias);
+    return;
+  }
+
+  int position = m_rows.size();
+  beginInsertRows(QModelIndex(), position, position);
+  Row row;
+  row.identity = identity;
+  row.alias = alias;
+  m_index.insert(identity, position);
+  m_rows.append(row);
+  endInsertRows();
+}
+
+void
+ContactListModel::removeContact(const QString& identity)
+{
+  QHash<QString, int>::iterator it = m_index.find(identity);
+  if (it == m_index.end())
+    return;
+
+  int position = it.value();
+  beginRemoveRows(QModelIndex(), position, position);
+  m_index.erase(it);
+  m_rows.remove(position);
+  // rows after the removed one moved up by one
+  for (int i = position; i < m_rows.size(); i++)
+    m_index[m_rows[i].identity] = i;
+  endRemoveRows();
+}
+
+void
+ContactListModel::setAlias(const QString& identity, const QString& alias)
+{
+  QHash<QString, int>::const_iterator it = m_index.find(identity);
+  if (it == m_index.end() || m_rows[it.value()].alias == alias)
+    return;
+
+  m_rows[it.value()].alias = alias;
+  QModelIndex changed = index(it.value());
+  emit dataChanged(changed, changed);
+}
+
+QString
+ContactListModel::getIdentity(const QModelIndex& index) const
+{
+  if (!index.isValid() || index.row() >= m_rows.size())
+    return QString();
+  return m_rows[index.row()].identity;
+}
+
+QString
+ContactListModel::getAlias(const QString& identity) const
+{
+  QHash<QString, int>::const_iterator it = m_index.find(identity);
+  if (it == m_index.end())
+    return QString();
+  return m_rows[it.value()].alias;
+}
+
+int
+ContactListModel::rowCount(const QModelIndex& parent) const
+{
+  if (parent.isValid())
+    return 0;
+  return m_rows.size();
+}
+
+QVariant
+ContactListModel::data(const QModelIndex& index, int role) const
+{
+  if (!index.isValid() || index.row() >= m_rows.size())
+    return QVariant();
+
+  if (role == Qt::DisplayRole)
+    return m_rows[index.row()].alias;
+  if (role == IdentityRole)
+    return m_rows[index.row()].identity;
+  return QVariant();
+}
+
+} // namespace chronochat
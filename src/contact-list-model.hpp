@@ -0,0 +1,79 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#ifndef CHRONOCHAT_CONTACT_LIST_MODEL_HPP
+#define CHRONOCHAT_CONTACT_LIST_MODEL_HPP
+
+#include <QAbstractListModel>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+
+namespace chronochat {
+
+/**
+ * @brief The contacts shown by ContactPanel, displayed by alias
+ *
+ * The model is reset from a snapshot of the contact list and then kept up to date with
+ * single-contact changes.  Contacts are looked up by identity in constant time, so
+ * renaming a contact only touches its own row.
+ */
+class ContactListModel : public QAbstractListModel
+{
+public:
+  /// @brief Role of the identity of a contact, the display role gives its alias
+  static const int IdentityRole = Qt::UserRole;
+
+  explicit
+  ContactListModel(QObject* parent = 0);
+
+  /// @brief Replace all rows, @p idList and @p aliasList are parallel lists
+  void
+  reset(const QStringList& idList, const QStringList& aliasList);
+
+  /// @brief Append a contact, or rename it if it is already in the model
+  void
+  addContact(const QString& identity, const QString& alias);
+
+  void
+  removeContact(const QString& identity);
+
+  void
+  setAlias(const QString& identity, const QString& alias);
+
+  /// @return the identity of the contact at @p index, empty if @p index is invalid
+  QString
+  getIdentity(const QModelIndex& index) const;
+
+  /// @return the alias of @p identity, empty if it is not in the model
+  QString
+  getAlias(const QString& identity) const;
+
+  virtual int
+  rowCount(const QModelIndex& parent = QModelIndex()) const;
+
+  virtual QVariant
+  data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+
+private:
+  struct Row
+  {
+    QString identity;
+    QString alias;
+  };
+
+  QVector<Row> m_rows;
+  // identity -> row in m_rows
+  QHash<QString, int> m_index;
+};
+
+} // namespace chronochat
+
+#endif // CHRONOCHAT_CONTACT_LIST_MODEL_HPP
@@ -15,17 +15,16 @@
 
 #include "contact-manager.hpp"
 #include <QStringList>
-#include <QFile>
 
 #ifndef Q_MOC_RUN
 #include <ndn-cxx/encoding/buffer-stream.hpp>
 #include <ndn-cxx/util/crypto.hpp>
-#include <ndn-cxx/security/sec-rule-relative.hpp>
-#include <ndn-cxx/security/validator-regex.hpp>
+#include "validation-policy.hpp"
+#include "signing-service.hpp"
 #include "cryptopp.hpp"
 #include <boost/asio.hpp>
-#include <boost/tokenizer.hpp>
 #include <boost/filesystem.hpp>
+#include <algorithm>
 #include "logging.h"
 #endif
 
@@ -40,100 +39,266 @@ using std::map;
 using std::vector;
 
 using ndn::Face;
-using ndn::OBufferStream;
 using ndn::IdentityCertificate;
 using ndn::Validator;
-using ndn::ValidatorRegex;
-using ndn::SecRuleRelative;
 using ndn::OnDataValidated;
 using ndn::OnDataValidationFailed;
 using ndn::OnInterestValidated;
 using ndn::OnInterestValidationFailed;
 
+// bounds of the endorsement evaluation caches, which are emptied when full
+static const size_t MAX_ENDORSE_VERDICTS = 4096;
+static const size_t MAX_ENDORSE_INFOS = 256;
+
+// bounds of the caches of fetched contact information
+static const size_t MAX_FETCHED_CONTACTS = 64;
+static const time::seconds FETCHED_CONTACT_TTL(300);
+static const size_t MAX_FETCHED_ID_CERTS = 1024;
+static const time::seconds FETCHED_ID_CERT_TTL(1800);
+static const size_t MAX_UNREACHABLE_NAMES = 256;
+static const time::seconds UNREACHABLE_TTL(15);
+
+/**
+ * A utility function to get the raw SHA-256 digest of a buffer, in the form used by
+ * EndorseCollection.
+ */
+static string
+computeDigest(const uint8_t* buf, size_t size)
+{
+  std::stringstream ss;
+  {
+    using namespace CryptoPP;
+
+    SHA256 hash;
+    StringSource(buf, size, true, new HashFilter(hash, new FileSink(ss)));
+  }
+  return ss.str();
+}
+
+
+const size_t ContactManager::DEFAULT_ENDORSE_CERT_FETCH_LIMIT = 16;
+const size_t ContactManager::DEFAULT_COLLECT_WINDOW = 32;
+const size_t ContactManager::DEFAULT_ID_CERT_WINDOW = 16;
 
 ContactManager::ContactManager(Face& face,
                                QObject* parent)
   : QObject(parent)
   , m_face(face)
+  , m_endorseCertFetchLimit(DEFAULT_ENDORSE_CERT_FETCH_LIMIT)
+  , m_storage(face.getIoService(), bind(&ContactManager::onStorageFailure, this, _1))
+  , m_bufferedContacts(MAX_FETCHED_CONTACTS, FETCHED_CONTACT_TTL)
+  , m_bufferedIdCerts(MAX_FETCHED_ID_CERTS, FETCHED_ID_CERT_TTL)
+  , m_unreachableContacts(MAX_UNREACHABLE_NAMES, UNREACHABLE_TTL)
+  , m_unreachableIdCerts(MAX_UNREACHABLE_NAMES, UNREACHABLE_TTL)
   , m_dnsListenerId(0)
+  , m_collectGroup(face.getIoService(), DEFAULT_COLLECT_WINDOW)
+  , m_certDirectory(face.getIoService())
+  , m_idCertGroup(face.getIoService(), DEFAULT_ID_CERT_WINDOW)
 {
   initializeSecurity();
 }
 
 ContactManager::~ContactManager()
 {
+  // the pending callbacks of both workers use this
+  m_storage.stop();
+  SigningService::getDefault().cancel(m_face.getIoService());
 }
 
-// private methods
-shared_ptr<IdentityCertificate>
-ContactManager::loadTrustAnchor()
+shared_ptr<Contact>
+ContactManager::getContact(const Name& identity)
 {
-  shared_ptr<IdentityCertificate> anchor;
+  UniqueRecLock lock(m_contactsMutex);
+  ContactIndex::const_iterator it = m_contacts.find(identity);
+  if (it == m_contacts.end())
+    return shared_ptr<Contact>();
 
-  QFile anchorFile(":/security/anchor.cert");
+  return it->second;
+}
 
-  if (!anchorFile.open(QIODevice::ReadOnly)) {
-    emit warning(QString("Cannot load trust anchor!"));
-    return anchor;
+void
+ContactManager::getContactList(ContactList& contactList)
+{
+  UniqueRecLock lock(m_contactsMutex);
+  contactList.clear();
+  for (ContactIndex::const_iterator it = m_contacts.begin(); it != m_contacts.end(); it++)
+    contactList.push_back(it->second);
+}
+
+// private methods
+void
+ContactManager::setContactList(const ContactList& contactList)
+{
+  UniqueRecLock lock(m_contactsMutex);
+  m_contacts.clear();
+  m_trustScopes.clear();
+  for (ContactList::const_iterator it = contactList.begin(); it != contactList.end(); it++) {
+    m_contacts[(*it)->getNameSpace()] = *it;
+    m_trustScopes.insert(**it);
+  }
+}
+
+void
+ContactManager::setContact(const Name& identity, const shared_ptr<Contact>& contact)
+{
+  shared_ptr<Contact> oldContact;
+  {
+    // cached contacts are never modified in place, readers may still hold the old one
+    UniqueRecLock lock(m_contactsMutex);
+    ContactIndex::iterator it = m_contacts.find(identity);
+    if (it != m_contacts.end())
+      oldContact = it->second;
+
+    m_trustScopes.erase(identity);
+    if (static_cast<bool>(contact)) {
+      m_contacts[identity] = contact;
+      m_trustScopes.insert(*contact);
+    }
+    else if (it != m_contacts.end())
+      m_contacts.erase(it);
   }
 
-  qint64 fileSize = anchorFile.size();
-  char* buf = new char[fileSize];
-  anchorFile.read(buf, fileSize);
+  QString qIdentity = QString::fromStdString(identity.toUri());
+  if (static_cast<bool>(oldContact) &&
+      (!static_cast<bool>(contact) ||
+       oldContact->getPublicKeyName() != contact->getPublicKeyName()))
+    emit contactRemoved(qIdentity, QString::fromStdString(oldContact->getPublicKeyName().toUri()));
 
-  try {
-    using namespace CryptoPP;
+  if (!static_cast<bool>(contact))
+    return;
 
-    OBufferStream os;
-    StringSource(reinterpret_cast<const uint8_t*>(buf), fileSize, true,
-                 new Base64Decoder(new FileSink(os)));
-    anchor = make_shared<IdentityCertificate>();
-    anchor->wireDecode(Block(os.buf()));
-  }
-  catch (CryptoPP::Exception& e) {
-    emit warning(QString("Cannot load trust anchor!"));
+  QString qAlias = QString::fromStdString(contact->getAlias());
+  if (!static_cast<bool>(oldContact) ||
+      oldContact->getPublicKeyName() != contact->getPublicKeyName())
+    emit contactAdded(qIdentity, qAlias);
+  else if (oldContact->getAlias() != contact->getAlias())
+    emit contactAliasChanged(qIdentity, qAlias);
+}
+
+bool
+ContactManager::addContact(const shared_ptr<Contact>& contact)
+{
+  {
+    UniqueRecLock lock(m_contactsMutex);
+    if (!m_contacts.insert(std::make_pair(contact->getNameSpace(), contact)).second) {
+      emit warning(QString("Contact %1 already exists")
+                   .arg(QString::fromStdString(contact->getNameSpace().toUri())));
+      return false;
+    }
+    m_trustScopes.insert(*contact);
   }
-  catch (IdentityCertificate::Error& e) {
+
+  m_storage.write([contact] (ContactStorage& storage) { storage.addContact(*contact); });
+  emit contactAdded(QString::fromStdString(contact->getNameSpace().toUri()),
+                    QString::fromStdString(contact->getAlias()));
+  return true;
+}
+
+void
+ContactManager::setEndorseCertFetchLimit(size_t limit)
+{
+  m_endorseCertFetchLimit = (limit > 0 ? limit : 1);
+}
+
+void
+ContactManager::onStorageFailure(const string& failInfo)
+{
+  emit warning(QString::fromStdString(failInfo));
+}
+
+void
+ContactManager::loadContacts(const function<void()>& onLoaded)
+{
+  m_storage.query<ContactList>(
+    [] (ContactStorage& storage) {
+      ContactList contactList;
+      storage.getAllContacts(contactList);
+      return contactList;
+    },
+    [this, onLoaded] (const ContactList& contactList) {
+      setContactList(contactList);
+      onWaitForContactList();
+      if (onLoaded)
+        onLoaded();
+    });
+}
+
+void
+ContactManager::reloadContact(const Name& identity, const ContactStorageWorker::Operation& update)
+{
+  m_storage.query<shared_ptr<Contact> >(
+    [identity, update] (ContactStorage& storage) {
+      if (update)
+        update(storage);
+      return storage.getContact(identity);
+    },
+    [this, identity] (const shared_ptr<Contact>& contact) {
+      setContact(identity, contact);
+    });
+}
+
+void
+ContactManager::initializeSecurity()
+{
+  shared_ptr<const ValidationPolicy> policy = ValidationPolicy::getContactPolicy();
+  if (!static_cast<bool>(policy->getTrustAnchor()))
     emit warning(QString("Cannot load trust anchor!"));
+
+  m_validator = policy->makeValidator(m_face);
+}
+
+void
+ContactManager::fetchContactInfo(const Name& identity)
+{
+  if (m_unreachableContacts.find(identity) != 0) {
+    emit contactInfoFetchFailed(QString::fromStdString(identity.toUri()));
+    return;
   }
-  catch(Block::Error& e) {
-    emit warning(QString("Cannot load trust anchor!"));
+
+  // the evaluation is redone against the current trust scopes, from its own cache
+  FetchedInfo* info = m_bufferedContacts.find(identity);
+  if (info != 0 && static_cast<bool>(info->m_endorseInfo)) {
+    prepareEndorseInfo(identity);
+    return;
   }
 
-  delete [] buf;
+  // try to fetch self-endorse-certificate via DNS PROFILE first.
+  Name interestName;
+  interestName.append(identity).append("DNS").append("PROFILE");
 
-  return anchor;
+  Interest interest(interestName);
+  interest.setInterestLifetime(time::milliseconds(1000));
+  interest.setMustBeFresh(true);
+
+  OnDataValidated onValidated =
+    bind(&ContactManager::onDnsSelfEndorseCertValidated, this, _1, identity);
+  OnDataValidationFailed onValidationFailed =
+    bind(&ContactManager::onDnsSelfEndorseCertValidationFailed, this, _1, _2, identity);
+  TimeoutNotify timeoutNotify =
+    bind(&ContactManager::onDnsSelfEndorseCertTimeoutNotify, this, _1, identity);
+
+  sendInterest(interest, onValidated, onValidationFailed, timeoutNotify, 0);
 }
 
 void
-ContactManager::initializeSecurity()
+ContactManager::onContactInfoFetchFailed(const Name& identity)
 {
-  shared_ptr<IdentityCertificate> anchor = loadTrustAnchor();
-
-  shared_ptr<ValidatorRegex> validator = make_shared<ValidatorRegex>(boost::ref(m_face));
-  validator->addDataVerificationRule(make_shared<SecRuleRelative>("^([^<DNS>]*)<DNS><ENDORSED>",
-                                                                  "^([^<KEY>]*)<KEY>(<>*)<><ID-CERT>$",
-                                                                  "==", "\\1", "\\1\\2", true));
-  validator->addDataVerificationRule(make_shared<SecRuleRelative>("^([^<DNS>]*)<DNS><><ENDORSEE>",
-                                                                  "^([^<KEY>]*)<KEY>(<>*)<><ID-CERT>$",
-                                                                  "==", "\\1", "\\1\\2", true));
-  validator->addDataVerificationRule(make_shared<SecRuleRelative>("^([^<DNS>]*)<DNS><PROFILE>",
-                                                                  "^([^<KEY>]*)<KEY>(<>*)<><ID-CERT>$",
-                                                                  "==", "\\1", "\\1\\2", true));
-  validator->addDataVerificationRule(make_shared<SecRuleRelative>("^([^<PROFILE-CERT>]*)<PROFILE-CERT>",
-                                                                  "^([^<KEY>]*)<KEY>(<>*<ksk-.*>)<ID-CERT>$",
-                                                                  "==", "\\1", "\\1\\2", true));
-  validator->addDataVerificationRule(make_shared<SecRuleRelative>("^([^<KEY>]*)<KEY>(<>*)<ksk-.*><ID-CERT>",
-                                                                  "^([^<KEY>]*)<KEY><dsk-.*><ID-CERT>$",
-                                                                  ">", "\\1\\2", "\\1", true));
-  validator->addDataVerificationRule(make_shared<SecRuleRelative>("^([^<KEY>]*)<KEY><dsk-.*><ID-CERT>",
-                                                                  "^([^<KEY>]*)<KEY>(<>*)<ksk-.*><ID-CERT>$",
-                                                                  "==", "\\1", "\\1\\2", true));
-  validator->addDataVerificationRule(make_shared<SecRuleRelative>("^(<>*)$",
-                                                                  "^([^<KEY>]*)<KEY>(<>*)<ksk-.*><ID-CERT>$",
-                                                                  ">", "\\1", "\\1\\2", true));
-  validator->addTrustAnchor(anchor);
-  m_validator = validator;
+  m_unreachableContacts.insert(identity, true);
+  emit contactInfoFetchFailed(QString::fromStdString(identity.toUri()));
+}
+
+void
+ContactManager::addFetchedContact(const Name& identity)
+{
+  FetchedInfo* info = m_bufferedContacts.find(identity);
+  if (info != 0) {
+    shared_ptr<Contact> contact = make_shared<Contact>(*info->m_selfEndorseCert);
+    if (addContact(contact))
+      m_bufferedContacts.erase(identity);
+  }
+  else
+    emit warning(QString("Failure: no information of %1")
+                 .arg(QString::fromStdString(identity.toUri())));
 }
 
 void
@@ -157,36 +322,119 @@ ContactManager::fetchCollectEndorse(const Name& identity)
 }
 
 void
-ContactManager::fetchEndorseCertificateInternal(const Name& identity, size_t certIndex)
+ContactManager::fetchEndorseCertificates(const Name& identity)
 {
-  shared_ptr<EndorseCollection> endorseCollection =
-    m_bufferedContacts[identity].m_endorseCollection;
+  FetchedInfo* info = m_bufferedContacts.find(identity);
+  if (info == 0)
+    return;
+
+  info->m_endorseCertList.clear();
+  info->m_endorseCertDigests.clear();
+  info->m_nextCertIndex = 0;
+  info->m_nPendingCerts = 0;
 
-  if(certIndex >= endorseCollection->getCollectionEntries().size())
+  size_t nCerts = info->m_endorseCollection->getCollectionEntries().size();
+  if (nCerts == 0) {
     prepareEndorseInfo(identity);
+    return;
+  }
 
-  Name interestName(endorseCollection->getCollectionEntries()[certIndex].certName);
+  while (info->m_nextCertIndex < nCerts && info->m_nPendingCerts < m_endorseCertFetchLimit)
+    fetchEndorseCertificateInternal(identity, info->m_nextCertIndex++);
+}
 
-  Interest interest(interestName);
+void
+ContactManager::fetchEndorseCertificateInternal(const Name& identity, size_t certIndex)
+{
+  FetchedInfo* info = m_bufferedContacts.find(identity);
+  if (info == 0)
+    return;
+
+  shared_ptr<EndorseCollection> endorseCollection = info->m_endorseCollection;
+
+  Interest interest(endorseCollection->getCollectionEntries()[certIndex].certName);
   interest.setInterestLifetime(time::milliseconds(1000));
   interest.setMustBeFresh(true);
 
+  info->m_nPendingCerts++;
   m_face.expressInterest(interest,
                          bind(&ContactManager::onEndorseCertificateInternal,
-                              this, _1, _2, identity, certIndex,
-                              endorseCollection->getCollectionEntries()[certIndex].hash),
+                              this, _1, _2, identity, endorseCollection, certIndex),
                          bind(&ContactManager::onEndorseCertificateInternalTimeout,
-                              this, _1, identity, certIndex));
+                              this, _1, identity, endorseCollection));
+}
+
+void
+ContactManager::onEndorseCertificateFetched(const Name& identity,
+                                            const shared_ptr<EndorseCollection>& endorseCollection)
+{
+  FetchedInfo* info = m_bufferedContacts.find(identity);
+  if (info == 0)
+    return;
+
+  info->m_nPendingCerts--;
+
+  if (info->m_nextCertIndex < endorseCollection->getCollectionEntries().size())
+    fetchEndorseCertificateInternal(identity, info->m_nextCertIndex++);
+  else if (info->m_nPendingCerts == 0)
+    prepareEndorseInfo(identity);
 }
 
 void
 ContactManager::prepareEndorseInfo(const Name& identity)
 {
   // _LOG_DEBUG("prepareEndorseInfo");
-  const Profile& profile = m_bufferedContacts[identity].m_selfEndorseCert->getProfile();
+  // the contact may have been evicted from the buffer while its information was fetched
+  FetchedInfo* fetched = m_bufferedContacts.find(identity);
+  if (fetched == 0)
+    return;
+
+  FetchedInfo& info = *fetched;
+  const Profile& profile = info.m_selfEndorseCert->getProfile();
+  const vector<shared_ptr<EndorseCertificate> >& certs = info.m_endorseCertList;
+
+  TrustScopeIndex::Introducers introducers;
+  {
+    UniqueRecLock lock(m_contactsMutex);
+    introducers = m_trustScopes.findIntroducers(profile.getIdentityName());
+  }
+
+  // The result only depends on the self-endorse-certificate, the endorse certificates and
+  // the keys of their trusted signers, so it is cached under the digests of those inputs.
+  vector<shared_ptr<Contact> > signers(certs.size());
+  vector<string> keyDigests(certs.size());
+  vector<string> inputs;
+  for (size_t i = 0; i < certs.size(); i++) {
+    Name signer = certs[i]->getSigner().getPrefix(-1);
+    if (introducers.count(signer) > 0)
+      signers[i] = getContact(signer);
+
+    string input = info.m_endorseCertDigests[i];
+    if (static_cast<bool>(signers[i])) {
+      const ndn::Buffer& key = signers[i]->getPublicKey().get();
+      keyDigests[i] = computeDigest(key.buf(), key.size());
+      input.append(1, '\1').append(keyDigests[i]);
+    }
+    else
+      input.append(1, '\0');
+    inputs.push_back(input);
+  }
+  std::sort(inputs.begin(), inputs.end());
+
+  const Block& selfEndorseWire = info.m_selfEndorseCert->wireEncode();
+  string infoKey = computeDigest(selfEndorseWire.wire(), selfEndorseWire.size());
+  for (vector<string>::const_iterator it = inputs.begin(); it != inputs.end(); it++)
+    infoKey.append(*it);
+
+  EndorseInfoCache::const_iterator cached = m_endorseInfos.find(infoKey);
+  if (cached != m_endorseInfos.end()) {
+    info.m_endorseInfo = cached->second;
+    emit contactEndorseInfoReady(*cached->second);
+    return;
+  }
 
   shared_ptr<EndorseInfo> endorseInfo = make_shared<EndorseInfo>();
-  m_bufferedContacts[identity].m_endorseInfo = endorseInfo;
+  info.m_endorseInfo = endorseInfo;
 
   map<string, size_t> endorseCount;
   for (Profile::const_iterator pIt = profile.begin(); pIt != profile.end(); pIt++) {
@@ -196,28 +444,26 @@ ContactManager::prepareEndorseInfo(const Name& identity)
 
   size_t endorseCertCount = 0;
 
-  vector<shared_ptr<EndorseCertificate> >::const_iterator cIt =
-    m_bufferedContacts[identity].m_endorseCertList.begin();
-  vector<shared_ptr<EndorseCertificate> >::const_iterator cEnd =
-    m_bufferedContacts[identity].m_endorseCertList.end();
-
-  for (; cIt != cEnd; cIt++, endorseCertCount++) {
-    shared_ptr<Contact> contact = getContact((*cIt)->getSigner().getPrefix(-1));
-    if (!static_cast<bool>(contact))
+  for (size_t i = 0; i < certs.size(); i++, endorseCertCount++) {
+    if (!static_cast<bool>(signers[i]))
       continue;
 
-    if (!contact->isIntroducer() ||
-        !contact->canBeTrustedFor(profile.getIdentityName()))
-      continue;
-
-    if (!Validator::verifySignature(**cIt, contact->getPublicKey()))
+    std::pair<string, string> verdictKey(info.m_endorseCertDigests[i], keyDigests[i]);
+    EndorseVerdicts::const_iterator verdict = m_endorseVerdicts.find(verdictKey);
+    if (verdict == m_endorseVerdicts.end()) {
+      if (m_endorseVerdicts.size() >= MAX_ENDORSE_VERDICTS)
+        m_endorseVerdicts.clear();
+      bool isValid = Validator::verifySignature(*certs[i], signers[i]->getPublicKey());
+      verdict = m_endorseVerdicts.insert(std::make_pair(verdictKey, isValid)).first;
+    }
+    if (!verdict->second)
       continue;
 
-    const Profile& tmpProfile = (*cIt)->getProfile();
+    const Profile& tmpProfile = certs[i]->getProfile();
     if (tmpProfile != profile)
       continue;
 
-    const vector<string>& endorseList = (*cIt)->getEndorseList();
+    const vector<string>& endorseList = certs[i]->getEndorseList();
     for (vector<string>::const_iterator eIt = endorseList.begin(); eIt != endorseList.end(); eIt++)
       endorseCount[*eIt] += 1;
   }
@@ -228,6 +474,10 @@ ContactManager::prepareEndorseInfo(const Name& identity)
     endorseInfo->addEndorsement(pIt->first, pIt->second, ss.str());
   }
 
+  if (m_endorseInfos.size() >= MAX_ENDORSE_INFOS)
+    m_endorseInfos.clear();
+  m_endorseInfos[infoKey] = endorseInfo;
+
   emit contactEndorseInfoReady (*endorseInfo);
 }
 
@@ -241,20 +491,22 @@ ContactManager::onDnsSelfEndorseCertValidated(const shared_ptr<const Data>& data
     shared_ptr<EndorseCertificate> selfEndorseCertificate =
       make_shared<EndorseCertificate>(boost::cref(plainData));
     if (Validator::verifySignature(plainData, selfEndorseCertificate->getPublicKeyInfo())) {
-      m_bufferedContacts[identity].m_selfEndorseCert = selfEndorseCertificate;
+      // a new round: responses to an earlier round of the same contact are dropped
+      FetchedInfo& info = m_bufferedContacts.insert(identity, FetchedInfo());
+      info.m_selfEndorseCert = selfEndorseCertificate;
       fetchCollectEndorse(identity);
     }
     else
-      emit contactInfoFetchFailed(QString::fromStdString(identity.toUri()));
+      onContactInfoFetchFailed(identity);
   }
   catch(Block::Error& e) {
-    emit contactInfoFetchFailed(QString::fromStdString(identity.toUri()));
+    onContactInfoFetchFailed(identity);
   }
   catch(EndorseCertificate::Error& e) {
-    emit contactInfoFetchFailed(QString::fromStdString(identity.toUri()));
+    onContactInfoFetchFailed(identity);
   }
   catch(Data::Error& e) {
-    emit contactInfoFetchFailed(QString::fromStdString(identity.toUri()));
+    onContactInfoFetchFailed(identity);
   }
 }
 
@@ -265,7 +517,7 @@ ContactManager::onDnsSelfEndorseCertValidationFailed(const shared_ptr<const Data
 {
   // If we cannot validate the Self-Endorse-Certificate, we may retry or fetch id-cert,
   // but let's stay with failure for now.
-  emit contactInfoFetchFailed(QString::fromStdString(identity.toUri()));
+  onContactInfoFetchFailed(identity);
 }
 
 void
@@ -274,7 +526,7 @@ ContactManager::onDnsSelfEndorseCertTimeoutNotify(const Interest& interest,
 {
   // If we cannot validate the Self-Endorse-Certificate, we may retry or fetch id-cert,
   // but let's stay with failure for now.
-  emit contactInfoFetchFailed(QString::fromStdString(identity.toUri()));
+  onContactInfoFetchFailed(identity);
 }
 
 void
@@ -284,8 +536,12 @@ ContactManager::onDnsCollectEndorseValidated(const shared_ptr<const Data>& data,
   try {
     shared_ptr<EndorseCollection> endorseCollection =
       make_shared<EndorseCollection>(data->getContent());
-    m_bufferedContacts[identity].m_endorseCollection = endorseCollection;
-    fetchEndorseCertificateInternal(identity, 0);
+    FetchedInfo* info = m_bufferedContacts.find(identity);
+    if (info == 0)
+      return;
+
+    info->m_endorseCollection = endorseCollection;
+    fetchEndorseCertificates(identity);
   }
   catch (tlv::Error) {
     prepareEndorseInfo(identity);
@@ -309,185 +565,359 @@ ContactManager::onDnsCollectEndorseTimeoutNotify(const Interest& interest, const
 
 void
 ContactManager::onEndorseCertificateInternal(const Interest& interest, Data& data,
-                                             const Name& identity, size_t certIndex,
-                                             string hash)
+                                             const Name& identity,
+                                             const shared_ptr<EndorseCollection>& endorseCollection,
+                                             size_t certIndex)
 {
-  std::stringstream ss;
-  {
-    using namespace CryptoPP;
-
-    SHA256 hash;
-    StringSource(data.wireEncode().wire(), data.wireEncode().size(), true,
-                 new HashFilter(hash, new FileSink(ss)));
-  }
+  // a newer collection of the same contact is being fetched, drop the stale response
+  FetchedInfo* info = m_bufferedContacts.find(identity);
+  if (info == 0 || info->m_endorseCollection != endorseCollection)
+    return;
 
-  if (ss.str() == hash) {
+  string digest = computeDigest(data.wireEncode().wire(), data.wireEncode().size());
+  if (digest == endorseCollection->getCollectionEntries()[certIndex].hash) {
     shared_ptr<EndorseCertificate> endorseCertificate =
       make_shared<EndorseCertificate>(boost::cref(data));
-    m_bufferedContacts[identity].m_endorseCertList.push_back(endorseCertificate);
+    info->m_endorseCertList.push_back(endorseCertificate);
+    info->m_endorseCertDigests.push_back(digest);
   }
 
-  fetchEndorseCertificateInternal(identity, certIndex+1);
+  onEndorseCertificateFetched(identity, endorseCollection);
 }
 
 void
 ContactManager::onEndorseCertificateInternalTimeout(const Interest& interest,
                                                     const Name& identity,
-                                                    size_t certIndex)
+                                                    const shared_ptr<EndorseCollection>&
+                                                      endorseCollection)
 {
-  fetchEndorseCertificateInternal(identity, certIndex+1);
+  FetchedInfo* info = m_bufferedContacts.find(identity);
+  if (info == 0 || info->m_endorseCollection != endorseCollection)
+    return;
+
+  onEndorseCertificateFetched(identity, endorseCollection);
 }
 
 void
 ContactManager::collectEndorsement()
 {
-  {
-    boost::recursive_mutex::scoped_lock lock(m_collectCountMutex);
-    m_collectCount = m_contactList.size();
+  m_storage.query<map<Name, uint64_t> >(
+    [] (ContactStorage& storage) {
+      map<Name, uint64_t> versions;
+      storage.getCollectEndorseVersions(versions);
+      return versions;
+    },
+    [this] (const map<Name, uint64_t>& versions) {
+      m_collectVersions = versions;
+      startCollectRound();
+    });
+}
 
-    for (ContactList::iterator it  = m_contactList.begin(); it != m_contactList.end(); it++) {
-      Name interestName = (*it)->getNameSpace();
-      interestName.append("DNS").append(m_identity.wireEncode()).append("ENDORSEE");
+void
+ContactManager::startCollectRound()
+{
+  ContactList contactList;
+  getContactList(contactList);
 
-      Interest interest(interestName);
-      interest.setInterestLifetime(time::milliseconds(1000));
+  // a new round supersedes the requests of the previous one
+  m_collectGroup.cancel();
+  if (contactList.empty())
+    return;
 
-      OnDataValidated onValidated = bind(&ContactManager::onDnsEndorseeValidated, this, _1);
-      OnDataValidationFailed onValidationFailed =
-        bind(&ContactManager::onDnsEndorseeValidationFailed, this, _1, _2);
-      TimeoutNotify timeoutNotify = bind(&ContactManager::onDnsEndorseeTimeoutNotify, this, _1);
+  // recently active contacts first, the others in contact-list order
+  std::stable_sort(contactList.begin(), contactList.end(),
+                   [this] (const shared_ptr<Contact>& a, const shared_ptr<Contact>& b) {
+                     return getLastActive(a->getNameSpace()) > getLastActive(b->getNameSpace());
+                   });
+
+  m_collectGroup.start([this] (size_t nDone, size_t nTotal) {
+                         emit collectEndorsementProgress(nDone, nTotal);
+                       },
+                       [this] (bool isComplete) { publishCollectEndorsedDataInDNS(); });
+
+  emit collectEndorsementProgress(0, contactList.size());
+  for (ContactList::const_iterator it = contactList.begin(); it != contactList.end(); it++)
+    m_collectGroup.add(bind(&ContactManager::requestEndorsee, this, (*it)->getNameSpace(), _1));
+  m_collectGroup.close();
+}
 
-      sendInterest(interest, onValidated, onValidationFailed, timeoutNotify, 0);
-    }
+void
+ContactManager::requestEndorsee(const Name& contact, const RequestGroup::Completion& done)
+{
+  Name interestName = contact;
+  interestName.append("DNS").append(m_identity.wireEncode()).append("ENDORSEE");
+
+  Interest interest(interestName);
+  interest.setInterestLifetime(time::milliseconds(1000));
+
+  // only a record newer than the collected one is worth sending
+  map<Name, uint64_t>::const_iterator version = m_collectVersions.find(contact);
+  if (version != m_collectVersions.end()) {
+    name::Component collected = name::Component::fromVersion(version->second);
+    interest.setExclude(ndn::Exclude().excludeUpTo(collected));
   }
+
+  m_face.expressInterest(interest,
+                         bind(&ContactManager::onDnsEndorseeData, this, _1, _2, contact, done),
+                         [done] (const Interest&) { done(); });
 }
 
 void
-ContactManager::onDnsEndorseeValidated(const shared_ptr<const Data>& data)
+ContactManager::onDnsEndorseeData(const Interest& interest, const Data& data,
+                                  const Name& contact, const RequestGroup::Completion& done)
 {
-  Data endorseData;
-  endorseData.wireDecode(data->getContent().blockFromValue());
+  m_lastActive[contact] = time::steady_clock::now();
+
+  // a record that is not newer than the collected one needs no verification
+  uint64_t version = 0;
+  try {
+    version = data.getName().get(-1).toVersion();
+  }
+  catch (tlv::Error&) {
+  }
 
-  EndorseCertificate endorseCertificate(endorseData);
-  m_contactStorage->updateCollectEndorse(endorseCertificate);
+  map<Name, uint64_t>::const_iterator collected = m_collectVersions.find(contact);
+  if (collected != m_collectVersions.end() && version != 0 && version <= collected->second) {
+    done();
+    return;
+  }
 
-  decreaseCollectStatus();
+  m_validator->validate(data,
+                        bind(&ContactManager::onDnsEndorseeValidated,
+                             this, _1, contact, version, done),
+                        [done] (const shared_ptr<const Data>&, const string&) { done(); });
 }
 
 void
-ContactManager::onDnsEndorseeValidationFailed(const shared_ptr<const Data>& data,
-                                              const string& failInfo)
+ContactManager::onDnsEndorseeValidated(const shared_ptr<const Data>& data, const Name& contact,
+                                       uint64_t version, const RequestGroup::Completion& done)
 {
-  decreaseCollectStatus();
+  Data endorseData;
+  endorseData.wireDecode(data->getContent().blockFromValue());
+
+  shared_ptr<EndorseCertificate> endorseCertificate = make_shared<EndorseCertificate>(endorseData);
+  // a newer endorsement from the same endorser supersedes a pending one
+  m_storage.write("CollectEndorse" + endorseCertificate->getSigner().toUri(),
+                  [endorseCertificate, contact, version] (ContactStorage& storage) {
+                    storage.updateCollectEndorse(*endorseCertificate, contact, version);
+                  });
+
+  m_collectVersions[contact] = version;
+  done();
 }
 
-void
-ContactManager::onDnsEndorseeTimeoutNotify(const Interest& interest)
+time::steady_clock::TimePoint
+ContactManager::getLastActive(const Name& identity) const
 {
-  decreaseCollectStatus();
+  std::map<Name, time::steady_clock::TimePoint>::const_iterator it = m_lastActive.find(identity);
+  if (it == m_lastActive.end())
+    return time::steady_clock::TimePoint();
+  return it->second;
 }
 
 void
-ContactManager::decreaseCollectStatus()
+ContactManager::setCollectWindow(size_t window)
 {
-  size_t count;
-  {
-    boost::recursive_mutex::scoped_lock lock(m_collectCountMutex);
-    m_collectCount--;
-    count = m_collectCount;
-  }
-
-  if(count == 0)
-    publishCollectEndorsedDataInDNS();
+  m_face.getIoService().post([this, window] { m_collectGroup.setLimit(window); });
 }
 
 void
 ContactManager::publishCollectEndorsedDataInDNS()
 {
-  Name dnsName = m_identity;
-  dnsName.append("DNS").append("ENDORSED").appendVersion();
+  m_storage.query<CollectedEndorsements>(
+    [] (ContactStorage& storage) {
+      CollectedEndorsements collected;
+      storage.getCollectEndorse(collected.collection);
+
+      // compare with the content of the published ENDORSED record
+      Data candidate;
+      candidate.setContent(collected.collection.wireEncode());
+      const Block& content = candidate.getContent();
+
+      shared_ptr<Data> published = storage.getDnsData("N/A", "ENDORSED");
+      collected.isChanged = !static_cast<bool>(published) ||
+                            published->getContent().size() != content.size() ||
+                            !std::equal(content.wire(), content.wire() + content.size(),
+                                        published->getContent().wire());
+      return collected;
+    },
+    [this] (const CollectedEndorsements& collected) {
+      if (!collected.isChanged)
+        return;
+
+      Name dnsName = m_identity;
+      dnsName.append("DNS").append("ENDORSED").appendVersion();
+
+      shared_ptr<Data> data = make_shared<Data>();
+      data->setName(dnsName);
+      data->setContent(collected.collection.wireEncode());
+
+      SigningService::getDefault().sign(data, m_identity, m_face.getIoService(),
+        [this, data] {
+          publishDnsData(data, [data] (ContactStorage& storage) {
+              storage.updateDnsOthersEndorse(*data);
+            });
+        },
+        bind(&ContactManager::onSigningFailed, this, _1));
+    });
+}
 
-  shared_ptr<Data> data = make_shared<Data>();
-  data->setName(dnsName);
+void
+ContactManager::refreshCertDirectory()
+{
+  m_listedIdCerts.clear();
 
-  EndorseCollection endorseCollection;
-  m_contactStorage->getCollectEndorse(endorseCollection);
+  emit idCertNameListReady(QStringList());
+  emit nameListReady(QStringList());
 
-  data->setContent(endorseCollection.wireEncode());
-  m_keyChain.signByIdentity(*data, m_identity);
+  // the round stays open while the directory is still listing certificates
+  m_idCertGroup.start(RequestGroup::OnProgress(), RequestGroup::OnDone());
 
-  m_contactStorage->updateDnsOthersEndorse(*data);
-  m_face.put(*data);
+  // a new fetch cancels the previous one, so listed names always belong to this round
+  m_certDirectory.fetch(bind(&ContactManager::onCertDirectoryEntry, this, _1),
+                        bind(&ContactManager::onCertDirectoryDone, this),
+                        bind(&ContactManager::onCertDirectoryFailed, this, _1));
 }
 
 void
-ContactManager::onIdentityCertValidated(const shared_ptr<const Data>& data)
+ContactManager::onCertDirectoryEntry(const string& certName)
 {
-  shared_ptr<IdentityCertificate> cert = make_shared<IdentityCertificate>(boost::cref(*data));
-  m_bufferedIdCerts[cert->getName()] = cert;
-  decreaseIdCertCount();
+  try {
+    m_idCertGroup.add(bind(&ContactManager::requestIdCert, this, Name(certName), _1));
+  }
+  catch (Name::Error&) {
+  }
 }
 
 void
-ContactManager::onIdentityCertValidationFailed(const shared_ptr<const Data>& data,
-                                               const string& failInfo)
+ContactManager::onCertDirectoryDone()
 {
-  // _LOG_DEBUG("ContactManager::onIdentityCertValidationFailed " << data->getName());
-  decreaseIdCertCount();
+  m_idCertGroup.close();
 }
 
 void
-ContactManager::onIdentityCertTimeoutNotify(const Interest& interest)
+ContactManager::onCertDirectoryFailed(const string& failInfo)
 {
-  // _LOG_DEBUG("ContactManager::onIdentityCertTimeoutNotify: " << interest.getName());
-  decreaseIdCertCount();
+  m_idCertGroup.close();
+  emit warning(QString::fromStdString("Fail to fetch certificate directory! " + failInfo));
 }
 
 void
-ContactManager::decreaseIdCertCount()
+ContactManager::requestIdCert(const Name& certName, const RequestGroup::Completion& done)
 {
-  size_t count;
-  {
-    boost::recursive_mutex::scoped_lock lock(m_idCertCountMutex);
-    m_idCertCount--;
-    count = m_idCertCount;
+  if (m_unreachableIdCerts.find(certName) != 0) {
+    done();
+    return;
   }
 
-  if (count == 0) {
-    QStringList certNameList;
-    QStringList nameList;
+  shared_ptr<IdentityCertificate>* cached = m_bufferedIdCerts.find(certName);
+  if (cached != 0) {
+    listIdCert(**cached);
+    done();
+    return;
+  }
 
-    for(BufferedIdCerts::const_iterator it = m_bufferedIdCerts.begin();
-        it != m_bufferedIdCerts.end(); it++) {
-      certNameList << QString::fromStdString(it->second->getName().toUri());
-      Profile profile(*(it->second));
-      nameList << QString::fromStdString(profile.get("name"));
-    }
+  Interest interest(certName);
+  interest.setInterestLifetime(time::milliseconds(1000));
+  interest.setMustBeFresh(true);
 
-    emit idCertNameListReady(certNameList);
-    emit nameListReady(nameList);
-  }
+  OnDataValidated onValidated =
+    bind(&ContactManager::onIdentityCertValidated, this, _1, done);
+  OnDataValidationFailed onValidationFailed =
+    bind(&ContactManager::onIdentityCertFailed, this, certName, done);
+  TimeoutNotify timeoutNotify =
+    bind(&ContactManager::onIdentityCertFailed, this, certName, done);
+
+  sendInterest(interest, onValidated, onValidationFailed, timeoutNotify, 0);
 }
 
-shared_ptr<EndorseCertificate>
-ContactManager::getSignedSelfEndorseCertificate(const Profile& profile)
+void
+ContactManager::onIdentityCertValidated(const shared_ptr<const Data>& data,
+                                        const RequestGroup::Completion& done)
 {
-  Name certificateName = m_keyChain.getDefaultCertificateNameForIdentity(m_identity);
+  shared_ptr<IdentityCertificate> cert = make_shared<IdentityCertificate>(boost::cref(*data));
+  m_bufferedIdCerts.insert(cert->getName(), cert);
+  ValidationPolicy::getContactPolicy()->getCertificateCache()->insertCertificate(cert);
+
+  // not listed if the directory was refreshed since the certificate was requested
+  if (done.isCurrent())
+    listIdCert(*cert);
+  done();
+}
+
+void
+ContactManager::onIdentityCertFailed(const Name& certName, const RequestGroup::Completion& done)
+{
+  m_unreachableIdCerts.insert(certName, true);
+  done();
+}
 
-  shared_ptr<IdentityCertificate> signingCert = m_keyChain.getCertificate(certificateName);
+void
+ContactManager::listIdCert(const IdentityCertificate& cert)
+{
+  if (m_listedIdCerts.insert(cert.getName()).second) {
+    Profile profile(cert);
+    emit idCertAdded(QString::fromStdString(cert.getName().toUri()),
+                     QString::fromStdString(profile.get("name")));
+  }
+}
 
-  vector<string> endorseList;
-  for (Profile::const_iterator it = profile.begin(); it != profile.end(); it++)
-    endorseList.push_back(it->first);
+void
+ContactManager::fetchIdCert(const Name& certName)
+{
+  shared_ptr<IdentityCertificate>* cert = m_bufferedIdCerts.find(certName);
+  if (cert != 0)
+    emit idCertReady(**cert);
+}
 
-  shared_ptr<EndorseCertificate> selfEndorseCertificate =
-    make_shared<EndorseCertificate>(boost::cref(*signingCert),
-                                    boost::cref(profile),
-                                    boost::cref(endorseList));
+void
+ContactManager::addFetchedContactIdCert(const Name& certName)
+{
+  shared_ptr<IdentityCertificate>* cert = m_bufferedIdCerts.find(certName);
+  if (cert != 0) {
+    shared_ptr<Contact> contact = make_shared<Contact>(**cert);
+    if (addContact(contact))
+      m_bufferedIdCerts.erase(certName);
+  }
+  else {
+    Name identity = IdentityCertificate::certificateNameToPublicKeyName(certName).getPrefix(-1);
+    emit warning(QString("Failure: no information of %1")
+                 .arg(QString::fromStdString(identity.toUri())));
+  }
+}
 
-  m_keyChain.sign(*selfEndorseCertificate, certificateName);
+void
+ContactManager::setCertDirectory(const string& host, const string& port, const string& path)
+{
+  m_certDirectory.setEndpoint(host, port, path);
+}
 
-  return selfEndorseCertificate;
+void
+ContactManager::publishSelfEndorseCertificate(const Profile& profile)
+{
+  Name identity = m_identity;
+  SigningService::getDefault().getCertificate(identity, m_face.getIoService(),
+    [this, identity, profile] (const shared_ptr<IdentityCertificate>& signingCert) {
+      vector<string> endorseList;
+      for (Profile::const_iterator it = profile.begin(); it != profile.end(); it++)
+        endorseList.push_back(it->first);
+
+      shared_ptr<EndorseCertificate> selfEndorseCertificate =
+        make_shared<EndorseCertificate>(boost::cref(*signingCert),
+                                        boost::cref(profile),
+                                        boost::cref(endorseList));
+
+      SigningService::getDefault().sign(selfEndorseCertificate, identity, m_face.getIoService(),
+        [this, selfEndorseCertificate] {
+          m_storage.write([selfEndorseCertificate] (ContactStorage& storage) {
+              storage.addSelfEndorseCertificate(*selfEndorseCertificate);
+            });
+
+          publishSelfEndorseCertificateInDNS(*selfEndorseCertificate);
+        },
+        bind(&ContactManager::onSigningFailed, this, _1));
+    },
+    bind(&ContactManager::onSigningFailed, this, _1));
 }
 
 void
@@ -501,35 +931,43 @@ ContactManager::publishSelfEndorseCertificateInDNS(const EndorseCertificate& sel
   data->setContent(selfEndorseCertificate.wireEncode());
   data->setFreshnessPeriod(time::milliseconds(1000));
 
-  m_keyChain.signByIdentity(*data, m_identity);
-
-  m_contactStorage->updateDnsSelfProfileData(*data);
-  m_face.put(*data);
+  SigningService::getDefault().sign(data, m_identity, m_face.getIoService(),
+    [this, data] {
+      publishDnsData(data, [data] (ContactStorage& storage) {
+          storage.updateDnsSelfProfileData(*data);
+        });
+    },
+    bind(&ContactManager::onSigningFailed, this, _1));
 }
 
-shared_ptr<EndorseCertificate>
-ContactManager::generateEndorseCertificate(const Name& identity)
+void
+ContactManager::publishEndorseCertificate(const shared_ptr<Contact>& contact,
+                                          const vector<string>& endorseList)
 {
-  shared_ptr<Contact> contact = getContact(identity);
-  if (!static_cast<bool>(contact))
-    return shared_ptr<EndorseCertificate>();
-
-  Name signerKeyName = m_keyChain.getDefaultKeyNameForIdentity(m_identity);
-
-  vector<string> endorseList;
-  m_contactStorage->getEndorseList(identity, endorseList);
-
-  shared_ptr<EndorseCertificate> cert =
-    shared_ptr<EndorseCertificate>(new EndorseCertificate(contact->getPublicKeyName(),
-                                                          contact->getPublicKey(),
-                                                          contact->getNotBefore(),
-                                                          contact->getNotAfter(),
-                                                          signerKeyName,
-                                                          contact->getProfile(),
-                                                          endorseList));
-  m_keyChain.signByIdentity(*cert, m_identity);
-  return cert;
-
+  Name identity = m_identity;
+  SigningService::getDefault().getCertificate(identity, m_face.getIoService(),
+    [this, identity, contact, endorseList] (const shared_ptr<IdentityCertificate>& signingCert) {
+      shared_ptr<EndorseCertificate> cert =
+        shared_ptr<EndorseCertificate>(new EndorseCertificate(contact->getPublicKeyName(),
+                                                              contact->getPublicKey(),
+                                                              contact->getNotBefore(),
+                                                              contact->getNotAfter(),
+                                                              signingCert->getPublicKeyName(),
+                                                              contact->getProfile(),
+                                                              endorseList));
+
+      Name endorsee = contact->getNameSpace();
+      SigningService::getDefault().sign(cert, identity, m_face.getIoService(),
+        [this, cert, endorsee] {
+          m_storage.write([cert, endorsee] (ContactStorage& storage) {
+              storage.addEndorseCertificate(*cert, endorsee);
+            });
+
+          publishEndorseCertificateInDNS(*cert);
+        },
+        bind(&ContactManager::onSigningFailed, this, _1));
+    },
+    bind(&ContactManager::onSigningFailed, this, _1));
 }
 
 void
@@ -546,9 +984,34 @@ ContactManager::publishEndorseCertificateInDNS(const EndorseCertificate& endorse
   data->setName(dnsName);
   data->setContent(endorseCertificate.wireEncode());
 
-  m_keyChain.signByIdentity(*data, m_identity);
+  string endorseeUri = dnsName.get(-3).toUri();
+  SigningService::getDefault().sign(data, m_identity, m_face.getIoService(),
+    [this, data, endorseeUri] {
+      publishDnsData(data, [data, endorseeUri] (ContactStorage& storage) {
+          storage.updateDnsEndorseOthers(*data, endorseeUri);
+        });
+    },
+    bind(&ContactManager::onSigningFailed, this, _1));
+}
+
+void
+ContactManager::onSigningFailed(const string& failInfo)
+{
+  emit warning(QString::fromStdString("Cannot sign with " + m_identity.toUri() + ": " +
+                                      failInfo));
+}
+
+void
+ContactManager::publishDnsData(const shared_ptr<Data>& data,
+                               const ContactStorageWorker::Operation& store)
+{
+  Name recordName = data->getName().getPrefix(-1);
 
-  m_contactStorage->updateDnsEndorseOthers(*data, dnsName.get(-3).toUri());
+  m_dnsCache.erase(recordName);
+  m_dnsCache.insert(*data);
+
+  // a newer version of the same record supersedes a pending write
+  m_storage.write(recordName.toUri(), store);
   m_face.put(*data);
 }
 
@@ -594,25 +1057,51 @@ void
 ContactManager::onDnsInterest(const Name& prefix, const Interest& interest)
 {
   const Name& interestName = interest.getName();
-  shared_ptr<Data> data;
+  string name;
+  string type;
 
   if (interestName.size() <= prefix.size())
     return;
 
-  if (interestName.size() == (prefix.size()+1)) {
-    data = m_contactStorage->getDnsData("N/A", interestName.get(prefix.size()).toUri());
-    if (static_cast<bool>(data))
-      m_face.put(*data);
+  // the cache holds the latest version of each record published or loaded since startup,
+  // storage holds no newer one, e.g. for interests excluding the cached version
+  if (static_cast<bool>(m_dnsCache.find(interestName))) {
+    shared_ptr<const Data> cachedData = m_dnsCache.find(interest);
+    if (static_cast<bool>(cachedData))
+      m_face.put(*cachedData);
     return;
   }
 
-  if (interestName.size() == (prefix.size()+2)) {
-    data = m_contactStorage->getDnsData(interestName.get(prefix.size()).toUri(),
-                                        interestName.get(prefix.size()+1).toUri());
-    if (static_cast<bool>(data))
-      m_face.put(*data);
-    return;
+  if (interestName.size() == (prefix.size()+1)) {
+    name = "N/A";
+    type = interestName.get(prefix.size()).toUri();
+  }
+  else if (interestName.size() == (prefix.size()+2)) {
+    name = interestName.get(prefix.size()).toUri();
+    type = interestName.get(prefix.size()+1).toUri();
   }
+  else
+    return;
+
+  m_storage.tryQuery<shared_ptr<Data> >(
+    [name, type] (ContactStorage& storage) {
+      return storage.getDnsData(name, type);
+    },
+    [this, interest] (const shared_ptr<Data>& data) {
+      if (!static_cast<bool>(data))
+        return;
+
+      // a record published meanwhile is newer than the stored one
+      if (!static_cast<bool>(m_dnsCache.find(interest.getName())))
+        m_dnsCache.insert(*data);
+
+      // the stored version may be the one the interest excludes
+      shared_ptr<const Data> matchedData = m_dnsCache.find(interest);
+      if (static_cast<bool>(matchedData))
+        m_face.put(*matchedData);
+    },
+    // under load the interest is left unanswered, its consumer expresses it again
+    [] (const string&) {});
 }
 
 void
@@ -628,7 +1117,7 @@ ContactManager::onIdentityUpdated(const QString& identity)
 {
   m_identity = Name(identity.toStdString());
 
-  m_contactStorage = make_shared<ContactStorage>(m_identity);
+  m_storage.open(m_identity);
 
   Name dnsPrefix;
   dnsPrefix.append(m_identity).append("DNS");
@@ -644,271 +1133,167 @@ ContactManager::onIdentityUpdated(const QString& identity)
 
   m_dnsListenerId = dnsListenerId;
 
-  m_contactList.clear();
-  m_contactStorage->getAllContacts(m_contactList);
+  setContactList(ContactList());
+  m_face.getIoService().post([this] {
+      m_bufferedContacts.clear();
+      m_unreachableContacts.clear();
+      m_endorseVerdicts.clear();
+      m_endorseInfos.clear();
+      m_dnsCache.erase(Name());
+    });
 
-  m_bufferedContacts.clear();
-
-  collectEndorsement();
+  loadContacts(bind(&ContactManager::collectEndorsement, this));
 }
 
 void
 ContactManager::onFetchContactInfo(const QString& identity)
 {
-  // try to fetch self-endorse-certificate via DNS PROFILE first.
-  Name identityName(identity.toStdString());
-  Name interestName;
-  interestName.append(identityName).append("DNS").append("PROFILE");
-
-  // _LOG_DEBUG("onFetchContactInfo " << identity.toStdString() << " profile: " << interestName);
-
-  Interest interest(interestName);
-  interest.setInterestLifetime(time::milliseconds(1000));
-  interest.setMustBeFresh(true);
-
-  OnDataValidated onValidated =
-    bind(&ContactManager::onDnsSelfEndorseCertValidated, this, _1, identityName);
-  OnDataValidationFailed onValidationFailed =
-    bind(&ContactManager::onDnsSelfEndorseCertValidationFailed, this, _1, _2, identityName);
-  TimeoutNotify timeoutNotify =
-    bind(&ContactManager::onDnsSelfEndorseCertTimeoutNotify, this, _1, identityName);
-
-  sendInterest(interest, onValidated, onValidationFailed, timeoutNotify, 0);
+  m_face.getIoService().post(bind(&ContactManager::fetchContactInfo,
+                                  this, Name(identity.toStdString())));
 }
 
 void
 ContactManager::onAddFetchedContact(const QString& identity)
 {
-  // _LOG_DEBUG("onAddFetchedContact");
-
-  Name identityName(identity.toStdString());
-
-  BufferedContacts::const_iterator it = m_bufferedContacts.find(identityName);
-  if (it != m_bufferedContacts.end()) {
-    Contact contact(*(it->second.m_selfEndorseCert));
-    // _LOG_DEBUG("onAddFetchedContact: contact ready");
-    try {
-      m_contactStorage->addContact(contact);
-      m_bufferedContacts.erase(identityName);
-
-      m_contactList.clear();
-      m_contactStorage->getAllContacts(m_contactList);
-
-      onWaitForContactList();
-    }
-    catch(ContactStorage::Error& e) {
-      emit warning(QString::fromStdString(e.what()));
-    }
-  }
-  else
-    emit warning(QString("Failure: no information of %1").arg(identity));
+  m_face.getIoService().post(bind(&ContactManager::addFetchedContact,
+                                  this, Name(identity.toStdString())));
 }
 
 void
 ContactManager::onUpdateProfile()
 {
   // Get current profile;
-  shared_ptr<Profile> newProfile = m_contactStorage->getSelfProfile();
-  if (!static_cast<bool>(newProfile))
-    return;
-
-  // _LOG_DEBUG("ContactManager::onUpdateProfile: getProfile");
-
-  shared_ptr<EndorseCertificate> newEndorseCertificate =
-    getSignedSelfEndorseCertificate(*newProfile);
-
-  m_contactStorage->addSelfEndorseCertificate(*newEndorseCertificate);
-
-  publishSelfEndorseCertificateInDNS(*newEndorseCertificate);
+  m_storage.query<shared_ptr<Profile> >(
+    [] (ContactStorage& storage) {
+      return storage.getSelfProfile();
+    },
+    [this] (const shared_ptr<Profile>& newProfile) {
+      if (!static_cast<bool>(newProfile))
+        return;
+
+      // _LOG_DEBUG("ContactManager::onUpdateProfile: getProfile");
+
+      publishSelfEndorseCertificate(*newProfile);
+    });
 }
 
 void
 ContactManager::onRefreshBrowseContact()
 {
-  vector<string> bufferedIdCertNames;
-  try {
-    using namespace boost::asio::ip;
-    tcp::iostream request_stream;
-    request_stream.expires_from_now(boost::posix_time::milliseconds(5000));
-    request_stream.connect("ndncert.named-data.net","80");
-    if (!request_stream) {
-      emit warning(QString::fromStdString("Fail to fetch certificate directory! #1"));
-      return;
-    }
-
-    request_stream << "GET /cert/list/ HTTP/1.0\r\n";
-    request_stream << "Host: ndncert.named-data.net\r\n\r\n";
-    request_stream.flush();
-
-    string line1;
-    std::getline(request_stream,line1);
-    if (!request_stream) {
-      emit warning(QString::fromStdString("Fail to fetch certificate directory! #2"));
-      return;
-    }
-
-    std::stringstream response_stream(line1);
-    string http_version;
-    response_stream >> http_version;
-    size_t status_code;
-    response_stream >> status_code;
-    string status_message;
-    std::getline(response_stream,status_message);
-
-    if (!response_stream ||
-        http_version.substr(0,5) != "HTTP/") {
-      emit warning(QString::fromStdString("Fail to fetch certificate directory! #3"));
-      return;
-    }
-    if (status_code!=200) {
-      emit warning(QString::fromStdString("Fail to fetch certificate directory! #4"));
-      return;
-    }
-    vector<string> headers;
-    string header;
-    while (std::getline(request_stream, header) && header != "\r")
-      headers.push_back(header);
-
-    std::istreambuf_iterator<char> stream_iter (request_stream);
-    std::istreambuf_iterator<char> end_of_stream;
-
-    typedef boost::tokenizer< boost::escaped_list_separator<char>,
-                              std::istreambuf_iterator<char> > tokenizer_t;
-    tokenizer_t certItems (stream_iter,
-                           end_of_stream,
-                           boost::escaped_list_separator<char>('\\', '\n', '"'));
-
-    for (tokenizer_t::iterator it = certItems.begin(); it != certItems.end (); it++)
-      if (!it->empty())
-        bufferedIdCertNames.push_back(*it);
-  }
-  catch(std::exception &e) {
-    emit warning(QString::fromStdString("Fail to fetch certificate directory! #N"));
-  }
-
-  {
-    boost::recursive_mutex::scoped_lock lock(m_idCertCountMutex);
-    m_idCertCount = bufferedIdCertNames.size();
-  }
-  m_bufferedIdCerts.clear();
-
-  for (vector<string>::const_iterator it = bufferedIdCertNames.begin();
-       it != bufferedIdCertNames.end(); it++) {
-    Name certName(*it);
-
-    Interest interest(certName);
-    interest.setInterestLifetime(time::milliseconds(1000));
-    interest.setMustBeFresh(true);
-
-    OnDataValidated onValidated =
-    bind(&ContactManager::onIdentityCertValidated, this, _1);
-    OnDataValidationFailed onValidationFailed =
-    bind(&ContactManager::onIdentityCertValidationFailed, this, _1, _2);
-    TimeoutNotify timeoutNotify =
-    bind(&ContactManager::onIdentityCertTimeoutNotify, this, _1);
-
-    sendInterest(interest, onValidated, onValidationFailed, timeoutNotify, 0);
-  }
+  m_face.getIoService().post(bind(&ContactManager::refreshCertDirectory, this));
 }
 
 void
 ContactManager::onFetchIdCert(const QString& qCertName)
 {
-  Name certName(qCertName.toStdString());
-  if (m_bufferedIdCerts.find(certName) != m_bufferedIdCerts.end())
-    emit idCertReady(*m_bufferedIdCerts[certName]);
+  m_face.getIoService().post(bind(&ContactManager::fetchIdCert,
+                                  this, Name(qCertName.toStdString())));
 }
 
 void
 ContactManager::onAddFetchedContactIdCert(const QString& qCertName)
 {
-  Name certName(qCertName.toStdString());
-  Name identity = IdentityCertificate::certificateNameToPublicKeyName(certName).getPrefix(-1);
-
-  BufferedIdCerts::const_iterator it = m_bufferedIdCerts.find(certName);
-  if (it != m_bufferedIdCerts.end()) {
-    Contact contact(*it->second);
-    try {
-      m_contactStorage->addContact(contact);
-      m_bufferedIdCerts.erase(certName);
-
-      m_contactList.clear();
-      m_contactStorage->getAllContacts(m_contactList);
-
-      onWaitForContactList();
-    }
-    catch(ContactStorage::Error& e) {
-      emit warning(QString::fromStdString(e.what()));
-    }
-  }
-  else
-    emit warning(QString("Failure: no information of %1")
-                 .arg(QString::fromStdString(identity.toUri())));
+  m_face.getIoService().post(bind(&ContactManager::addFetchedContactIdCert,
+                                  this, Name(qCertName.toStdString())));
 }
 
 void
 ContactManager::onWaitForContactList()
 {
-  QStringList aliasList;
+  ContactList contactList;
+  getContactList(contactList);
+
   QStringList idList;
-  for (ContactList::const_iterator it = m_contactList.begin(); it != m_contactList.end(); it++) {
-    aliasList << QString((*it)->getAlias().c_str());
+  QStringList aliasList;
+  for (ContactList::const_iterator it = contactList.begin(); it != contactList.end(); it++) {
     idList << QString((*it)->getNameSpace().toUri().c_str());
+    aliasList << QString((*it)->getAlias().c_str());
   }
 
-  emit contactAliasListReady(aliasList);
-  emit contactIdListReady(idList);
+  emit contactListReady(idList, aliasList);
 }
 
 void
 ContactManager::onWaitForContactInfo(const QString& identity)
 {
-  for (ContactList::const_iterator it = m_contactList.begin(); it != m_contactList.end(); it++)
-    if ((*it)->getNameSpace().toUri() == identity.toStdString())
-      emit contactInfoReady(QString((*it)->getNameSpace().toUri().c_str()),
-                            QString((*it)->getName().c_str()),
-                            QString((*it)->getInstitution().c_str()),
-                            (*it)->isIntroducer());
+  shared_ptr<Contact> contact = getContact(Name(identity.toStdString()));
+  if (static_cast<bool>(contact))
+    emit contactInfoReady(QString(contact->getNameSpace().toUri().c_str()),
+                          QString(contact->getName().c_str()),
+                          QString(contact->getInstitution().c_str()),
+                          contact->isIntroducer());
 }
 
 void
 ContactManager::onRemoveContact(const QString& identity)
 {
-  m_contactStorage->removeContact(Name(identity.toStdString()));
-  m_contactList.clear();
-  m_contactStorage->getAllContacts(m_contactList);
-
-  onWaitForContactList();
+  Name identityName(identity.toStdString());
+  setContact(identityName, shared_ptr<Contact>());
+  m_storage.write([identityName] (ContactStorage& storage) {
+      storage.removeContact(identityName);
+    });
 }
 
 void
 ContactManager::onUpdateAlias(const QString& identity, const QString& alias)
 {
-  m_contactStorage->updateAlias(Name(identity.toStdString()), alias.toStdString());
-  m_contactList.clear();
-  m_contactStorage->getAllContacts(m_contactList);
+  Name identityName(identity.toStdString());
+  shared_ptr<Contact> contact = getContact(identityName);
+  if (!static_cast<bool>(contact))
+    return;
 
-  onWaitForContactList();
+  string aliasString = alias.toStdString();
+  shared_ptr<Contact> newContact = make_shared<Contact>(*contact);
+  newContact->setAlias(aliasString);
+  setContact(identityName, newContact);
+  m_storage.write([identityName, aliasString] (ContactStorage& storage) {
+      storage.updateAlias(identityName, aliasString);
+    });
 }
 
 void
 ContactManager::onUpdateIsIntroducer(const QString& identity, bool isIntroducer)
 {
-  m_contactStorage->updateIsIntroducer(Name(identity.toStdString()), isIntroducer);
+  Name identityName(identity.toStdString());
+  shared_ptr<Contact> contact = getContact(identityName);
+  if (!static_cast<bool>(contact))
+    return;
+
+  shared_ptr<Contact> newContact = make_shared<Contact>(*contact);
+  newContact->setIsIntroducer(isIntroducer);
+  setContact(identityName, newContact);
+
+  // trust scopes are only loaded for introducers, so pick them up from the storage
+  reloadContact(identityName, [identityName, isIntroducer] (ContactStorage& storage) {
+      storage.updateIsIntroducer(identityName, isIntroducer);
+    });
+}
+
+void
+ContactManager::onUpdateTrustScope(const QString& identity)
+{
+  // trust scopes are edited by ContactPanel directly in the DB
+  reloadContact(Name(identity.toStdString()), ContactStorageWorker::Operation());
 }
 
 void
 ContactManager::onUpdateEndorseCertificate(const QString& identity)
 {
   Name identityName(identity.toStdString());
-  shared_ptr<EndorseCertificate> newEndorseCertificate = generateEndorseCertificate(identityName);
-
-  if (!static_cast<bool>(newEndorseCertificate))
+  shared_ptr<Contact> contact = getContact(identityName);
+  if (!static_cast<bool>(contact))
     return;
 
-  m_contactStorage->addEndorseCertificate(*newEndorseCertificate, identityName);
-
-  publishEndorseCertificateInDNS(*newEndorseCertificate);
+  // the endorse list is edited by ContactPanel directly in the DB
+  m_storage.query<vector<string> >(
+    [identityName] (ContactStorage& storage) {
+      vector<string> endorseList;
+      storage.getEndorseList(identityName, endorseList);
+      return endorseList;
+    },
+    [this, contact] (const vector<string>& endorseList) {
+      publishEndorseCertificate(contact, endorseList);
+    });
 }
 
 } // namespace chronochat
@@ -16,13 +16,17 @@
 
 #ifndef Q_MOC_RUN
 #include "common.hpp"
-#include "contact-storage.hpp"
+#include "contact-storage-worker.hpp"
+#include "trust-scope-index.hpp"
+#include "cert-directory-fetcher.hpp"
+#include "request-group.hpp"
+#include "lru-cache.hpp"
 #include "endorse-certificate.hpp"
 #include "profile.hpp"
 #include "endorse-info.hpp"
 #include "endorse-collection.hpp"
-#include <ndn-cxx/security/key-chain.hpp>
 #include <ndn-cxx/security/validator.hpp>
+#include <ndn-cxx/util/in-memory-storage-persistent.hpp>
 #include <boost/thread/locks.hpp>
 #include <boost/thread/recursive_mutex.hpp>
 #endif
@@ -36,36 +40,92 @@ class ContactManager : public QObject
 {
   Q_OBJECT
 
+  typedef boost::recursive_mutex RecLock;
+  typedef boost::unique_lock<RecLock> UniqueRecLock;
+
 public:
+  static const size_t DEFAULT_ENDORSE_CERT_FETCH_LIMIT;
+  static const size_t DEFAULT_COLLECT_WINDOW;
+  static const size_t DEFAULT_ID_CERT_WINDOW;
+
   ContactManager(ndn::Face& m_face, QObject* parent = 0);
 
   ~ContactManager();
 
+  /// @brief Set how many endorse certificates of a contact may be fetched at the same time
+  void
+  setEndorseCertFetchLimit(size_t limit);
+
+  /// @brief Set how many contacts are asked for their endorsement at the same time
+  void
+  setCollectWindow(size_t window);
+
+  /// @brief Set the HTTP endpoint of the certificate directory browsed for new contacts
+  void
+  setCertDirectory(const std::string& host, const std::string& port, const std::string& path);
+
   shared_ptr<Contact>
-  getContact(const Name& identity)
-  {
-    return m_contactStorage->getContact(identity);
-  }
+  getContact(const Name& identity);
 
   void
-  getContactList(ContactList& contactList)
-  {
-    contactList.clear();
-    contactList.insert(contactList.end(), m_contactList.begin(), m_contactList.end());
-  }
+  getContactList(ContactList& contactList);
+
 private:
-  shared_ptr<ndn::IdentityCertificate>
-  loadTrustAnchor();
+  void
+  setContactList(const ContactList& contactList);
+
+  /**
+   * @brief Replace the cached contact of @p identity, or remove it if @p contact is null
+   *
+   * The change is announced with contactAdded, contactRemoved or contactAliasChanged.
+   */
+  void
+  setContact(const Name& identity, const shared_ptr<Contact>& contact);
+
+  /// @return false if the contact already exists, otherwise contactAdded is emitted
+  bool
+  addContact(const shared_ptr<Contact>& contact);
+
+  void
+  onStorageFailure(const std::string& failInfo);
+
+  /// @brief Load all contacts from the storage into the contact index
+  void
+  loadContacts(const function<void()>& onLoaded);
+
+  /// @brief Apply @p update on the storage, then reload the contact of @p identity from it
+  void
+  reloadContact(const Name& identity, const ContactStorageWorker::Operation& update);
 
   void
   initializeSecurity();
 
+  /// @brief Fetch the profile and endorsements of @p identity, unless they are cached
+  void
+  fetchContactInfo(const Name& identity);
+
+  /// @brief Remember that @p identity cannot be fetched for a while and report it
+  void
+  onContactInfoFetchFailed(const Name& identity);
+
+  void
+  addFetchedContact(const Name& identity);
+
   void
   fetchCollectEndorse(const Name& identity);
 
+  /// @brief Fetch all certificates of the buffered endorse collection of @p identity
+  void
+  fetchEndorseCertificates(const Name& identity);
+
   void
   fetchEndorseCertificateInternal(const Name& identity, size_t certIndex);
 
+  /// @brief Account for a finished fetch and start the next one, or evaluate if all are done
+  void
+  onEndorseCertificateFetched(const Name& identity,
+                              const shared_ptr<EndorseCollection>& endorseCollection);
+
   void
   prepareEndorseInfo(const Name& identity);
 
@@ -98,61 +158,103 @@ private:
   // PROFILE-CERT: endorse-certificate
   void
   onEndorseCertificateInternal(const Interest& interest, Data& data,
-                               const Name& identity, size_t certIndex,
-                               std::string hash);
+                               const Name& identity,
+                               const shared_ptr<EndorseCollection>& endorseCollection,
+                               size_t certIndex);
 
   void
   onEndorseCertificateInternalTimeout(const Interest& interest,
                                       const Name& identity,
-                                      size_t certIndex);
+                                      const shared_ptr<EndorseCollection>& endorseCollection);
 
   // Collect endorsement
   void
   collectEndorsement();
 
+  /// @brief Start a new round of endorsement collection with all contacts
   void
-  onDnsEndorseeValidated(const shared_ptr<const Data>& data);
+  startCollectRound();
 
+  /// @brief Ask @p contact for its endorsement as a request of the collection round
   void
-  onDnsEndorseeValidationFailed(const shared_ptr<const Data>& data,
-                                const std::string& failInfo);
+  requestEndorsee(const Name& contact, const RequestGroup::Completion& done);
 
   void
-  onDnsEndorseeTimeoutNotify(const Interest& interest);
+  onDnsEndorseeData(const Interest& interest, const Data& data,
+                    const Name& contact, const RequestGroup::Completion& done);
 
   void
-  decreaseCollectStatus();
+  onDnsEndorseeValidated(const shared_ptr<const Data>& data, const Name& contact,
+                         uint64_t version, const RequestGroup::Completion& done);
+
+  time::steady_clock::TimePoint
+  getLastActive(const Name& identity) const;
 
   void
   publishCollectEndorsedDataInDNS();
 
   // Identity certificate
+  /// @brief Fetch the certificate directory and the certificates it lists
   void
-  onIdentityCertValidated(const shared_ptr<const Data>& data);
+  refreshCertDirectory();
 
   void
-  onIdentityCertValidationFailed(const shared_ptr<const Data>& data, const std::string& failInfo);
+  onCertDirectoryEntry(const std::string& certName);
 
   void
-  onIdentityCertTimeoutNotify(const Interest& interest);
+  onCertDirectoryFailed(const std::string& failInfo);
 
   void
-  decreaseIdCertCount();
+  onCertDirectoryDone();
 
-  // Publish self-endorse certificate
-  shared_ptr<EndorseCertificate>
-  getSignedSelfEndorseCertificate(const Profile& profile);
+  /// @brief Fetch @p certName as a request of the directory round
+  void
+  requestIdCert(const Name& certName, const RequestGroup::Completion& done);
+
+  void
+  onIdentityCertValidated(const shared_ptr<const Data>& data,
+                          const RequestGroup::Completion& done);
+
+  void
+  onIdentityCertFailed(const Name& certName, const RequestGroup::Completion& done);
+
+  /// @brief Show a fetched certificate in the list of the directory round
+  void
+  listIdCert(const ndn::IdentityCertificate& cert);
+
+  void
+  fetchIdCert(const Name& certName);
+
+  void
+  addFetchedContactIdCert(const Name& certName);
+
+  /// @brief Sign a self-endorse certificate of @p profile, then store and publish it
+  void
+  publishSelfEndorseCertificate(const Profile& profile);
 
   void
   publishSelfEndorseCertificateInDNS(const EndorseCertificate& selfEndorseCertificate);
 
-  // Publish endorse certificate
-  shared_ptr<EndorseCertificate>
-  generateEndorseCertificate(const Name& identity);
+  /// @brief Sign an endorse certificate of @p contact, then store and publish it
+  void
+  publishEndorseCertificate(const shared_ptr<Contact>& contact,
+                            const std::vector<std::string>& endorseList);
 
   void
   publishEndorseCertificateInDNS(const EndorseCertificate& endorseCertificate);
 
+  void
+  onSigningFailed(const std::string& failInfo);
+
+  /**
+   * @brief Serve @p data as the latest version of its DNS record
+   *
+   * The record replaces older versions in the in-memory DNS cache and is written through
+   * to the storage by @p store.
+   */
+  void
+  publishDnsData(const shared_ptr<Data>& data, const ContactStorageWorker::Operation& store);
+
   // Communication
   void
   sendInterest(const Interest& interest,
@@ -194,14 +296,26 @@ signals:
   void
   nameListReady(const QStringList& certNameList);
 
+  /// @brief A certificate listed in the directory has been fetched and validated
+  void
+  idCertAdded(const QString& certName, const QString& name);
+
   void
   idCertReady(const ndn::IdentityCertificate& idCert);
 
+  /// @brief A snapshot of the contact list, @p idList and @p aliasList are parallel lists
   void
-  contactAliasListReady(const QStringList& aliasList);
+  contactListReady(const QStringList& idList, const QStringList& aliasList);
 
   void
-  contactIdListReady(const QStringList& idList);
+  contactAdded(const QString& identity, const QString& alias);
+
+  /// @param keyName name of the public key of the removed contact
+  void
+  contactRemoved(const QString& identity, const QString& keyName);
+
+  void
+  contactAliasChanged(const QString& identity, const QString& alias);
 
   void
   contactInfoReady(const QString& identity,
@@ -212,6 +326,9 @@ signals:
   void
   warning(const QString& msg);
 
+  void
+  collectEndorsementProgress(int nDone, int nTotal);
+
 public slots:
   void
   onIdentityUpdated(const QString& identity);
@@ -249,45 +366,89 @@ public slots:
   void
   onUpdateIsIntroducer(const QString& identity, bool isIntro);
 
+  void
+  onUpdateTrustScope(const QString& identity);
+
   void
   onUpdateEndorseCertificate(const QString& identity);
 
 private:
 
   class FetchedInfo {
+  public:
+    FetchedInfo()
+      : m_nextCertIndex(0)
+      , m_nPendingCerts(0)
+    {
+    }
+
   public:
     shared_ptr<EndorseCertificate> m_selfEndorseCert;
     shared_ptr<EndorseCollection> m_endorseCollection;
     std::vector<shared_ptr<EndorseCertificate> > m_endorseCertList;
+    // SHA-256 digest of each certificate in m_endorseCertList
+    std::vector<std::string> m_endorseCertDigests;
     shared_ptr<EndorseInfo> m_endorseInfo;
+    // progress of fetching the certificates of m_endorseCollection
+    size_t m_nextCertIndex;
+    size_t m_nPendingCerts;
   };
 
-  typedef std::map<Name, FetchedInfo> BufferedContacts;
-  typedef std::map<Name, shared_ptr<ndn::IdentityCertificate> > BufferedIdCerts;
+  typedef std::map<Name, shared_ptr<Contact> > ContactIndex;
+  typedef LruCache<Name, FetchedInfo> BufferedContacts;
+  typedef LruCache<Name, shared_ptr<ndn::IdentityCertificate> > BufferedIdCerts;
+  // names that recently failed to be fetched or validated
+  typedef LruCache<Name, bool> UnreachableNames;
+  // (certificate digest, signer key digest) -> whether the signature is valid
+  typedef std::map<std::pair<std::string, std::string>, bool> EndorseVerdicts;
+  typedef std::map<std::string, shared_ptr<EndorseInfo> > EndorseInfoCache;
 
-  typedef boost::recursive_mutex RecLock;
-  typedef boost::unique_lock<RecLock> UniqueRecLock;
+  struct CollectedEndorsements
+  {
+    EndorseCollection collection;
+    // whether the collection differs from the published ENDORSED record
+    bool isChanged;
+  };
 
   // Conf
-  shared_ptr<ContactStorage> m_contactStorage;
   shared_ptr<ndn::Validator> m_validator;
   ndn::Face& m_face;
-  ndn::KeyChain m_keyChain;
+  size_t m_endorseCertFetchLimit;
+  ContactStorageWorker m_storage;
   Name m_identity;
-  ContactList m_contactList;
+  // authoritative for reads, every mutation is written through to m_storage
+  RecLock m_contactsMutex;
+  ContactIndex m_contacts;
+  // trust scopes of the introducers in m_contacts
+  TrustScopeIndex m_trustScopes;
 
-  // Buffer
+  // Buffer, only touched on the Face's thread
   BufferedContacts m_bufferedContacts;
   BufferedIdCerts m_bufferedIdCerts;
+  UnreachableNames m_unreachableContacts;
+  UnreachableNames m_unreachableIdCerts;
+
+  // Endorsement evaluation, only touched on the Face's thread
+  EndorseVerdicts m_endorseVerdicts;
+  EndorseInfoCache m_endorseInfos;
 
   // Tmp Dns
   const ndn::RegisteredPrefixId* m_dnsListenerId;
-
-  RecLock m_collectCountMutex;
-  size_t m_collectCount;
-
-  RecLock m_idCertCountMutex;
-  size_t m_idCertCount;
+  // latest version of each DNS record, only touched on the Face's thread
+  ndn::util::InMemoryStoragePersistent m_dnsCache;
+
+  // Endorsement collection, only touched on the Face's thread
+  RequestGroup m_collectGroup;
+  // when each contact last answered us
+  std::map<Name, time::steady_clock::TimePoint> m_lastActive;
+  // version of the last ENDORSEE record collected from each contact
+  std::map<Name, uint64_t> m_collectVersions;
+
+  // Certificate directory, only touched on the Face's thread
+  CertDirectoryFetcher m_certDirectory;
+  RequestGroup m_idCertGroup;
+  // certificates listed in the current directory round
+  std::set<Name> m_listedIdCerts;
 };
 
 } // namespace chronochat
@@ -14,6 +14,7 @@
 #include <QMenu>
 #include <QItemSelectionModel>
 #include <QModelIndex>
+#include <QtSql/QSqlDatabase>
 #include <QtSql/QSqlRecord>
 #include <QtSql/QSqlField>
 #include <QtSql/QSqlError>
@@ -30,7 +31,7 @@ ContactPanel::ContactPanel(QWidget *parent)
   : QDialog(parent)
   , ui(new Ui::ContactPanel)
   , m_setAliasDialog(new SetAliasDialog)
-  , m_contactListModel(new QStringListModel)
+  , m_contactListModel(new ContactListModel)
   , m_trustScopeModel(0)
   , m_endorseDataModel(0)
   , m_endorseComboBoxDelegate(new EndorseComboBoxDelegate)
@@ -119,10 +120,29 @@ ContactPanel::resetPanel()
   ui->endorseList->setEnabled(false);
 
   // Clean up contact list.
-  m_contactAliasList.clear();
-  m_contactIdList.clear();
   m_currentSelectedContact.clear();
-  m_contactListModel->setStringList(m_contactAliasList);
+  m_contactListModel->reset(QStringList(), QStringList());
+}
+
+void
+ContactPanel::selectSnapshot()
+{
+  // Both models are read inside one read transaction, which in WAL mode is a single
+  // snapshot that never waits for the backend writer.  All rows are fetched before
+  // the transaction ends, so no read statement is left open afterwards.
+  QSqlDatabase db = m_trustScopeModel->database();
+  bool inTransaction = db.transaction();
+
+  m_trustScopeModel->select();
+  while (m_trustScopeModel->canFetchMore())
+    m_trustScopeModel->fetchMore();
+
+  m_endorseDataModel->select();
+  while (m_endorseDataModel->canFetchMore())
+    m_endorseDataModel->fetchMore();
+
+  if (inTransaction)
+    db.commit();
 }
 
 // public slots
@@ -149,17 +169,30 @@ ContactPanel::onIdentityUpdated(const QString& identity)
 }
 
 void
-ContactPanel::onContactAliasListReady(const QStringList& aliasList)
+ContactPanel::onContactListReady(const QStringList& idList, const QStringList& aliasList)
 {
-  m_contactAliasList = aliasList;
-  m_contactListModel->setStringList(m_contactAliasList);
+  m_currentSelectedContact.clear();
+  m_contactListModel->reset(idList, aliasList);
 }
 
 void
-ContactPanel::onContactIdListReady(const QStringList& idList)
+ContactPanel::onContactAdded(const QString& identity, const QString& alias)
 {
-  m_currentSelectedContact.clear();
-  m_contactIdList = idList;
+  m_contactListModel->addContact(identity, alias);
+}
+
+void
+ContactPanel::onContactRemoved(const QString& identity)
+{
+  if (identity == m_currentSelectedContact)
+    m_currentSelectedContact.clear();
+  m_contactListModel->removeContact(identity);
+}
+
+void
+ContactPanel::onContactAliasChanged(const QString& identity, const QString& alias)
+{
+  m_contactListModel->setAlias(identity, alias);
 }
 
 void
@@ -176,7 +209,14 @@ ContactPanel::onContactInfoReady(const QString& identity,
   m_trustScopeModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
   m_trustScopeModel->setTable("TrustScope");
   m_trustScopeModel->setFilter(filter);
-  m_trustScopeModel->select();
+
+  QString filter2 = QString("profile_identity = '%1'").arg(identity);
+  m_endorseDataModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
+  m_endorseDataModel->setTable("ContactProfile");
+  m_endorseDataModel->setFilter(filter2);
+
+  selectSnapshot();
+
   ui->trustScopeList->setModel(m_trustScopeModel);
   ui->trustScopeList->setColumnHidden(0, true);
   ui->trustScopeList->setColumnHidden(1, true);
@@ -195,11 +235,6 @@ ContactPanel::onContactInfoReady(const QString& identity,
     ui->trustScopeList->setEnabled(false);
   }
 
-  QString filter2 = QString("profile_identity = '%1'").arg(identity);
-  m_endorseDataModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
-  m_endorseDataModel->setTable("ContactProfile");
-  m_endorseDataModel->setFilter(filter2);
-  m_endorseDataModel->select();
   ui->endorseList->setModel(m_endorseDataModel);
   ui->endorseList->setColumnHidden(0, true);
   ui->endorseList->resizeColumnToContents(1);
@@ -215,22 +250,16 @@ ContactPanel::onSelectionChanged(const QItemSelection &selected,
                                  const QItemSelection &deselected)
 {
   QModelIndexList items = selected.indexes();
-  QString alias = m_contactListModel->data(items.first(), Qt::DisplayRole).toString();
-
-  bool contactFound = false;
-  for (int i = 0; i < m_contactAliasList.size(); i++) {
-    if (alias == m_contactAliasList[i]) {
-      contactFound = true;
-      m_currentSelectedContact = m_contactIdList[i];
-      break;
-    }
-  }
+  if (items.isEmpty())
+    return;
 
-  if (!contactFound) {
+  QString identity = m_contactListModel->getIdentity(items.first());
+  if (identity.isEmpty()) {
     emit warning("This should not happen: ContactPanel::updateSelection #1");
     return;
   }
 
+  m_currentSelectedContact = identity;
   emit waitForContactInfo(m_currentSelectedContact);
 }
 
@@ -253,12 +282,12 @@ ContactPanel::onContextMenuRequested(const QPoint& pos)
 void
 ContactPanel::onSetAliasDialogRequested()
 {
-  for (int i = 0; i < m_contactIdList.size(); i++)
-    if (m_contactIdList[i] == m_currentSelectedContact) {
-      m_setAliasDialog->setTargetIdentity(m_currentSelectedContact, m_contactAliasList[i]);
-      m_setAliasDialog->show();
-      return;
-    }
+  if (m_currentSelectedContact.isEmpty())
+    return;
+
+  m_setAliasDialog->setTargetIdentity(m_currentSelectedContact,
+                                      m_contactListModel->getAlias(m_currentSelectedContact));
+  m_setAliasDialog->show();
 }
 
 void
@@ -268,12 +297,11 @@ ContactPanel::onContactDeletionRequested()
   QModelIndexList selectedList = selectionModel->selectedIndexes();
 
   for (QModelIndexList::iterator it = selectedList.begin(); it != selectedList.end(); it++) {
-    QString alias =  m_contactListModel->data(*it, Qt::DisplayRole).toString();
-    for (int i = 0; i < m_contactAliasList.size(); i++)
-      if (m_contactAliasList[i] == alias) {
-        emit removeContact(m_contactIdList[i]);
-        return;
-      }
+    QString identity = m_contactListModel->getIdentity(*it);
+    if (!identity.isEmpty()) {
+      emit removeContact(identity);
+      return;
+    }
   }
 }
 
@@ -316,12 +344,14 @@ ContactPanel::onDeleteScopeClicked()
     m_trustScopeModel->removeRow(indexList[i].row());
 
   m_trustScopeModel->submitAll();
+  emit updateTrustScope(m_currentSelectedContact);
 }
 
 void
 ContactPanel::onSaveScopeClicked()
 {
   m_trustScopeModel->submitAll();
+  emit updateTrustScope(m_currentSelectedContact);
 }
 
 void
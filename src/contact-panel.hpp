@@ -12,10 +12,10 @@
 #define CHRONOCHAT_CONTACT_PANEL_HPP
 
 #include <QDialog>
-#include <QStringListModel>
 #include <QSqlTableModel>
 
 #include "set-alias-dialog.hpp"
+#include "contact-list-model.hpp"
 #include "endorse-combobox-delegate.hpp"
 
 #ifndef Q_MOC_RUN
@@ -42,6 +42,10 @@ private:
   void
   resetPanel();
 
+  /// @brief Select the trust scope and endorse models from one consistent DB snapshot
+  void
+  selectSnapshot();
+
 signals:
   void
   waitForContactList();
@@ -58,6 +62,9 @@ signals:
   void
   updateIsIntroducer(const QString& identity, bool isIntro);
 
+  void
+  updateTrustScope(const QString& identity);
+
   void
   updateEndorseCertificate(const QString& identity);
 
@@ -72,10 +79,16 @@ public slots:
   onIdentityUpdated(const QString& identity);
 
   void
-  onContactAliasListReady(const QStringList& aliasList);
+  onContactListReady(const QStringList& idList, const QStringList& aliasList);
+
+  void
+  onContactAdded(const QString& identity, const QString& alias);
+
+  void
+  onContactRemoved(const QString& identity);
 
   void
-  onContactIdListReady(const QStringList& idList);
+  onContactAliasChanged(const QString& identity, const QString& alias);
 
   void
   onContactInfoReady(const QString& identity,
@@ -122,7 +135,7 @@ private:
   SetAliasDialog* m_setAliasDialog;
 
   // Models.
-  QStringListModel* m_contactListModel;
+  ContactListModel* m_contactListModel;
   QSqlTableModel*   m_trustScopeModel;
   QSqlTableModel*   m_endorseDataModel;
 
@@ -134,8 +147,6 @@ private:
   QAction* m_menuDelete;
 
   // Internal data structure.
-  QStringList m_contactAliasList;
-  QStringList m_contactIdList;
   QString     m_currentSelectedContact;
 };
 
@@ -0,0 +1,174 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#include "contact-storage-worker.hpp"
+
+namespace chronochat {
+
+using std::string;
+
+const size_t ContactStorageWorker::DEFAULT_QUEUE_LIMIT = 1024;
+
+ContactStorageWorker::ContactStorageWorker(boost::asio::io_service& ioService,
+                                           const OnFailure& onFailure,
+                                           size_t queueLimit)
+  : m_ioService(ioService)
+  , m_onFailure(onFailure)
+  , m_queueLimit(queueLimit)
+  , m_isStopping(false)
+{
+  m_thread = std::thread(&ContactStorageWorker::run, this);
+}
+
+ContactStorageWorker::~ContactStorageWorker()
+{
+  stop();
+}
+
+void
+ContactStorageWorker::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_isStopping = true;
+  }
+  m_hasTask.notify_all();
+  if (m_thread.joinable())
+    m_thread.join();
+}
+
+void
+ContactStorageWorker::open(const Name& identity)
+{
+  enqueue(string(),
+          [this, identity] {
+            m_storage.reset();
+            m_storage = make_shared<ContactStorage>(identity);
+          },
+          OnDone(), OnFailure());
+}
+
+void
+ContactStorageWorker::write(const Operation& operation,
+                            const OnDone& onDone, const OnFailure& onFailure)
+{
+  enqueue(string(), bindStorage(operation), onDone, onFailure);
+}
+
+void
+ContactStorageWorker::write(const string& key, const Operation& operation)
+{
+  enqueue(key, bindStorage(operation), OnDone(), OnFailure());
+}
+
+size_t
+ContactStorageWorker::getQueueSize() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_queue.size();
+}
+
+ContactStorageWorker::Job
+ContactStorageWorker::bindStorage(const Operation& operation)
+{
+  return [this, operation] {
+    if (!static_cast<bool>(m_storage))
+      throw ContactStorage::Error("Contact storage is not open");
+    operation(*m_storage);
+  };
+}
+
+void
+ContactStorageWorker::enqueue(const string& key, const Job& job,
+                              const OnDone& onDone, const OnFailure& onFailure,
+                              bool isBounded)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_isStopping)
+      return;
+
+    if (!key.empty()) {
+      std::map<string, shared_ptr<Task> >::iterator it = m_pendingWrites.find(key);
+      if (it != m_pendingWrites.end()) {
+        it->second->job = job;
+        return;
+      }
+    }
+
+    if (isBounded && m_queue.size() >= m_queueLimit) {
+      OnFailure failure = onFailure ? onFailure : m_onFailure;
+      if (failure)
+        m_ioService.post(bind(failure, string("Contact storage queue is full")));
+      return;
+    }
+
+    shared_ptr<Task> task = make_shared<Task>();
+    task->key = key;
+    task->job = job;
+    task->onDone = onDone;
+    task->onFailure = onFailure;
+
+    m_queue.push_back(task);
+    if (!key.empty())
+      m_pendingWrites[key] = task;
+  }
+  m_hasTask.notify_one();
+}
+
+void
+ContactStorageWorker::run()
+{
+  while (true) {
+    shared_ptr<Task> task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_hasTask.wait(lock, [this] { return m_isStopping || !m_queue.empty(); });
+      if (m_queue.empty())
+        return;
+
+      task = m_queue.front();
+      m_queue.pop_front();
+      if (!task->key.empty())
+        m_pendingWrites.erase(task->key);
+    }
+
+    execute(*task);
+  }
+}
+
+void
+ContactStorageWorker::execute(const Task& task)
+{
+  string failure;
+  try {
+    task.job();
+  }
+  catch (std::exception& e) {
+    failure = e.what();
+  }
+
+  // callbacks are posted under the lock, so that none is posted once stop() is called
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_isStopping)
+    return;
+
+  if (failure.empty()) {
+    if (task.onDone)
+      m_ioService.post(task.onDone);
+  }
+  else {
+    OnFailure onFailure = task.onFailure ? task.onFailure : m_onFailure;
+    if (onFailure)
+      m_ioService.post(bind(onFailure, failure));
+  }
+}
+
+} // namespace chronochat
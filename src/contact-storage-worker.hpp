@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#ifndef CHRONOCHAT_CONTACT_STORAGE_WORKER_HPP
+#define CHRONOCHAT_CONTACT_STORAGE_WORKER_HPP
+
+#include "contact-storage.hpp"
+#include <boost/asio/io_service.hpp>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace chronochat {
+
+/**
+ * @brief Runs ContactStorage operations on a dedicated thread
+ *
+ * Operations are executed one at a time, in the order they were queued, by a single
+ * worker thread that owns the storage, so a query always observes the writes queued
+ * before it.  Results and failures are delivered by callbacks posted to @p ioService.
+ *
+ * Writes and queries are never refused, as the callers keep state in memory that must
+ * match the storage; a write queued with a key replaces a not-yet-started write with the
+ * same key instead of taking more room.  Reads made with tryQuery(), which answer the
+ * network, fail at once when the queue holds @p queueLimit operations, so that the thread
+ * running @p ioService never waits for the worker.
+ *
+ * The owner of the callbacks must stop() the worker before they are destroyed.
+ */
+class ContactStorageWorker : noncopyable
+{
+public:
+  typedef function<void(ContactStorage&)> Operation;
+  typedef function<void()> OnDone;
+  typedef function<void(const std::string&)> OnFailure;
+
+  static const size_t DEFAULT_QUEUE_LIMIT;
+
+  /**
+   * @param ioService  where callbacks are posted
+   * @param onFailure  called for failed operations that have no own failure callback
+   */
+  ContactStorageWorker(boost::asio::io_service& ioService,
+                       const OnFailure& onFailure,
+                       size_t queueLimit = DEFAULT_QUEUE_LIMIT);
+
+  /// @brief Stop the worker if it is still running
+  ~ContactStorageWorker();
+
+  /**
+   * @brief Execute the queued operations and stop the worker
+   *
+   * No callback is posted once this is called, and operations queued later are dropped.
+   */
+  void
+  stop();
+
+  /// @brief Open the storage of @p identity, replacing the current one
+  void
+  open(const Name& identity);
+
+  void
+  write(const Operation& operation,
+        const OnDone& onDone = OnDone(),
+        const OnFailure& onFailure = OnFailure());
+
+  /**
+   * @brief Queue a write that supersedes any pending write with the same @p key
+   *
+   * The replacement keeps the queue position of the write it replaces.
+   */
+  void
+  write(const std::string& key, const Operation& operation);
+
+  /**
+   * @brief Run @p operation on the worker and pass its result to @p onResult
+   *
+   * @p operation may also modify the storage, e.g., to return the contact list after an
+   * update in a single step.
+   */
+  template<typename T>
+  void
+  query(const function<T(ContactStorage&)>& operation,
+        const function<void(const T&)>& onResult,
+        const OnFailure& onFailure = OnFailure())
+  {
+    shared_ptr<T> result = make_shared<T>();
+    enqueue(std::string(),
+            bindStorage([operation, result] (ContactStorage& storage) {
+                *result = operation(storage);
+              }),
+            [onResult, result] { onResult(*result); },
+            onFailure);
+  }
+
+  /**
+   * @brief Like query(), but @p onFailure is called instead if the queue is full
+   *
+   * @p operation must only read the storage.
+   */
+  template<typename T>
+  void
+  tryQuery(const function<T(ContactStorage&)>& operation,
+           const function<void(const T&)>& onResult,
+           const OnFailure& onFailure)
+  {
+    shared_ptr<T> result = make_shared<T>();
+    enqueue(std::string(),
+            bindStorage([operation, result] (ContactStorage& storage) {
+                *result = operation(storage);
+              }),
+            [onResult, result] { onResult(*result); },
+            onFailure, true);
+  }
+
+  /// @return number of queued operations that have not started
+  size_t
+  getQueueSize() const;
+
+private:
+  typedef function<void()> Job;
+
+  struct Task
+  {
+    std::string key;
+    Job job;
+    OnDone onDone;
+    OnFailure onFailure;
+  };
+
+  /// @brief Wrap @p operation into a job that runs it on the current storage
+  Job
+  bindStorage(const Operation& operation);
+
+  /**
+   * @brief Queue @p job, or replace the job of the pending write with the same @p key
+   *
+   * If the queue is full and @p isBounded, the failure callback is posted instead.
+   */
+  void
+  enqueue(const std::string& key, const Job& job,
+          const OnDone& onDone, const OnFailure& onFailure,
+          bool isBounded = false);
+
+  void
+  run();
+
+  void
+  execute(const Task& task);
+
+private:
+  boost::asio::io_service& m_ioService;
+  OnFailure m_onFailure;
+  size_t m_queueLimit;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_hasTask;
+  std::deque<shared_ptr<Task> > m_queue;
+  std::map<std::string, shared_ptr<Task> > m_pendingWrites;
+  bool m_isStopping;
+
+  // only touched by the worker thread
+  shared_ptr<ContactStorage> m_storage;
+
+  std::thread m_thread;
+};
+
+} // namespace chronochat
+
+#endif // CHRONOCHAT_CONTACT_STORAGE_WORKER_HPP
@@ -27,6 +27,17 @@ using std::vector;
 
 using ndn::PublicKey;
 
+// WAL journaling with synchronous=NORMAL syncs only at checkpoints and stays consistent
+// across application crashes; reads go through a 64MB memory map.
+const char* const STORAGE_PROFILE[] = {
+  "PRAGMA journal_mode=WAL",
+  "PRAGMA synchronous=NORMAL",
+  "PRAGMA mmap_size=67108864"
+};
+
+// the storage is used by a worker thread, which can wait for the GUI to finish a read
+const int BUSY_TIMEOUT_MS = 5000;
+
 // user's own profile;
 const string INIT_SP_TABLE =
   "CREATE TABLE IF NOT EXISTS                          "
@@ -101,6 +112,16 @@ const string INIT_CE_TABLE =
   "      endorser          BLOB NOT NULL,   "
   "      endorse_name      BLOB NOT NULL,   "
   "      endorse_data      BLOB NOT NULL,   "
+  "      endorse_hash      BLOB,            "
+  "      PRIMARY KEY (endorser)             "
+  "  );                                     ";
+
+// version of the last ENDORSEE record collected from each contact
+const string INIT_CV_TABLE =
+  "CREATE TABLE IF NOT EXISTS               "
+  "  CollectEndorseVersion(                 "
+  "      endorser          BLOB NOT NULL,   "
+  "      dns_version       INTEGER NOT NULL,"
   "      PRIMARY KEY (endorser)             "
   "  );                                     ";
 
@@ -163,6 +184,23 @@ sqlite3_column_block(sqlite3_stmt* statement, int column)
                sqlite3_column_bytes(statement, column));
 }
 
+/**
+ * The hash of a collected endorse certificate as used in EndorseCollection: the raw
+ * SHA-256 digest of the certificate wire encoding.
+ */
+static string
+computeEndorseHash(const uint8_t* wire, size_t size)
+{
+  std::stringstream ss;
+  {
+    using namespace CryptoPP;
+    SHA256 hash;
+
+    StringSource(wire, size, true, new HashFilter(hash, new FileSink(ss)));
+  }
+  return ss.str();
+}
+
 
 ContactStorage::ContactStorage(const Name& identity)
   : m_identity(identity)
@@ -174,6 +212,8 @@ ContactStorage::ContactStorage(const Name& identity)
   if (res != SQLITE_OK)
     throw Error("chronochat DB cannot be open/created");
 
+  applyStorageProfile();
+
   initializeTable("SelfProfile", INIT_SP_TABLE);
   initializeTable("SelfEndorse", INIT_SE_TABLE);
   initializeTable("Contact", INIT_CONTACT_TABLE);
@@ -181,8 +221,99 @@ ContactStorage::ContactStorage(const Name& identity)
   initializeTable("ContactProfile", INIT_CP_TABLE);
   initializeTable("ProfileEndorse", INIT_PE_TABLE);
   initializeTable("CollectEndorse", INIT_CE_TABLE);
+  initializeTable("CollectEndorseVersion", INIT_CV_TABLE);
   initializeTable("DnsData", INIT_DD_TABLE);
 
+  upgradeCollectEndorseTable();
+}
+
+ContactStorage::~ContactStorage()
+{
+  for (StatementCache::iterator it = m_statements.begin(); it != m_statements.end(); it++)
+    sqlite3_finalize(it->second);
+
+  sqlite3_close(m_db);
+}
+
+ContactStorage::Statement::Statement(const ContactStorage& storage, const string& sql)
+  : m_stmt(storage.getCachedStatement(sql))
+{
+}
+
+ContactStorage::Statement::~Statement()
+{
+  sqlite3_reset(m_stmt);
+  sqlite3_clear_bindings(m_stmt);
+}
+
+ContactStorage::Transaction::Transaction(const ContactStorage& storage)
+  : m_storage(storage)
+  , m_isCommitted(false)
+{
+  if (sqlite3_exec(m_storage.m_db, "BEGIN IMMEDIATE", NULL, NULL, NULL) != SQLITE_OK)
+    throw Error("Cannot begin transaction: " + string(sqlite3_errmsg(m_storage.m_db)));
+}
+
+ContactStorage::Transaction::~Transaction()
+{
+  if (!m_isCommitted)
+    sqlite3_exec(m_storage.m_db, "ROLLBACK", NULL, NULL, NULL);
+}
+
+void
+ContactStorage::Transaction::commit()
+{
+  if (sqlite3_exec(m_storage.m_db, "COMMIT", NULL, NULL, NULL) != SQLITE_OK)
+    throw Error("Cannot commit transaction: " + string(sqlite3_errmsg(m_storage.m_db)));
+  m_isCommitted = true;
+}
+
+void
+ContactStorage::executeWrite(sqlite3_stmt* stmt) const
+{
+  if (sqlite3_step(stmt) != SQLITE_DONE)
+    throw Error("Cannot write: " + string(sqlite3_errmsg(m_db)));
+}
+
+sqlite3_stmt*
+ContactStorage::getCachedStatement(const string& sql) const
+{
+  StatementCache::iterator it = m_statements.find(sql);
+  if (it != m_statements.end())
+    return it->second;
+
+  sqlite3_stmt* stmt = 0;
+  int res = sqlite3_prepare_v2(m_db, sql.c_str(), -1, &stmt, 0);
+  if (res != SQLITE_OK)
+    throw Error("Cannot prepare statement: " + string(sqlite3_errmsg(m_db)));
+
+  m_statements[sql] = stmt;
+  return stmt;
+}
+
+const vector<string>&
+ContactStorage::getStorageProfile()
+{
+  static const vector<string> profile(STORAGE_PROFILE,
+                                      STORAGE_PROFILE + sizeof(STORAGE_PROFILE) /
+                                                        sizeof(STORAGE_PROFILE[0]));
+  return profile;
+}
+
+void
+ContactStorage::applyStorageProfile()
+{
+  sqlite3_busy_timeout(m_db, BUSY_TIMEOUT_MS);
+
+  const vector<string>& profile = getStorageProfile();
+  for (vector<string>::const_iterator it = profile.begin(); it != profile.end(); it++) {
+    char* errmsg = 0;
+    if (sqlite3_exec(m_db, it->c_str(), NULL, NULL, &errmsg) != SQLITE_OK) {
+      string error = (errmsg != 0 ? errmsg : "unknown error");
+      sqlite3_free(errmsg);
+      throw Error("Cannot apply \"" + *it + "\": " + error);
+    }
+  }
 }
 
 string
@@ -226,19 +357,51 @@ ContactStorage::initializeTable(const string& tableName, const string& sqlCreate
   }
 }
 
+void
+ContactStorage::upgradeCollectEndorseTable()
+{
+  bool hasHashColumn = false;
+  {
+    Statement stmt(*this, "PRAGMA table_info(CollectEndorse)");
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+      if (sqlite3_column_string(stmt, 1) == "endorse_hash")
+        hasHashColumn = true;
+  }
+  if (hasHashColumn)
+    return;
+
+  // tables created before the hash column existed: add it and hash the stored certificates
+  Transaction transaction(*this);
+
+  if (sqlite3_exec(m_db, "ALTER TABLE CollectEndorse ADD COLUMN endorse_hash BLOB",
+                   NULL, NULL, NULL) != SQLITE_OK)
+    throw Error("Cannot upgrade CollectEndorse: " + string(sqlite3_errmsg(m_db)));
+
+  Statement select(*this, "SELECT endorser, endorse_data FROM CollectEndorse");
+  Statement update(*this, "UPDATE CollectEndorse SET endorse_hash=? WHERE endorser=?");
+  while (sqlite3_step(select) == SQLITE_ROW) {
+    const uint8_t* wire = static_cast<const uint8_t*>(sqlite3_column_blob(select, 1));
+    string hash = computeEndorseHash(wire, sqlite3_column_bytes(select, 1));
+    sqlite3_bind_blob(update, 1, hash.c_str(), hash.size(), SQLITE_TRANSIENT);
+    sqlite3_bind_string(update, 2, sqlite3_column_string(select, 0), SQLITE_TRANSIENT);
+    sqlite3_step(update);
+    sqlite3_reset(update);
+  }
+
+  transaction.commit();
+}
+
 shared_ptr<Profile>
 ContactStorage::getSelfProfile()
 {
   shared_ptr<Profile> profile = make_shared<Profile>(m_identity);
-  sqlite3_stmt *stmt;
-  sqlite3_prepare_v2(m_db, "SELECT profile_type, profile_value FROM SelfProfile", -1, &stmt, 0);
+  Statement stmt(*this, "SELECT profile_type, profile_value FROM SelfProfile");
 
   while (sqlite3_step(stmt) == SQLITE_ROW) {
     string profileType = sqlite3_column_string(stmt, 0);
     string profileValue = sqlite3_column_string (stmt, 1);
     (*profile)[profileType] = profileValue;
   }
-  sqlite3_finalize(stmt);
 
   return profile;
 }
@@ -246,117 +409,171 @@ ContactStorage::getSelfProfile()
 void
 ContactStorage::addSelfEndorseCertificate(const EndorseCertificate& newEndorseCertificate)
 {
-  sqlite3_stmt *stmt;
-  sqlite3_prepare_v2(m_db,
-                     "INSERT OR REPLACE INTO SelfEndorse (identity, endorse_data) values (?, ?)",
-                     -1, &stmt, 0);
+  Statement stmt(*this,
+                 "INSERT OR REPLACE INTO SelfEndorse (identity, endorse_data) values (?, ?)");
   sqlite3_bind_string(stmt, 1, m_identity.toUri(), SQLITE_TRANSIENT);
   sqlite3_bind_block(stmt, 2, newEndorseCertificate.wireEncode(), SQLITE_TRANSIENT);
   sqlite3_step(stmt);
-
-  sqlite3_finalize(stmt);
 }
 
 void
 ContactStorage::addEndorseCertificate(const EndorseCertificate& endorseCertificate,
                                       const Name& identity)
 {
-  sqlite3_stmt *stmt;
-  sqlite3_prepare_v2(m_db,
-                     "INSERT OR REPLACE INTO ProfileEndorse \
-                      (identity, endorse_data) values (?, ?)",
-                     -1, &stmt, 0);
+  Statement stmt(*this,
+                 "INSERT OR REPLACE INTO ProfileEndorse \
+                  (identity, endorse_data) values (?, ?)");
   sqlite3_bind_string(stmt, 1, identity.toUri(), SQLITE_TRANSIENT);
   sqlite3_bind_block(stmt, 2, endorseCertificate.wireEncode(), SQLITE_TRANSIENT);
   sqlite3_step(stmt);
-
-  sqlite3_finalize(stmt);
 }
 
 void
 ContactStorage::updateCollectEndorse(const EndorseCertificate& endorseCertificate)
+{
+  updateCollectEndorseInternal(endorseCertificate);
+}
+
+void
+ContactStorage::updateCollectEndorse(const vector<shared_ptr<EndorseCertificate> >& certificates)
+{
+  Transaction transaction(*this);
+
+  for (vector<shared_ptr<EndorseCertificate> >::const_iterator it = certificates.begin();
+       it != certificates.end(); it++)
+    updateCollectEndorseInternal(**it);
+
+  transaction.commit();
+}
+
+void
+ContactStorage::updateCollectEndorse(const EndorseCertificate& endorseCertificate,
+                                     const Name& endorser, uint64_t dnsVersion)
+{
+  Transaction transaction(*this);
+
+  updateCollectEndorseInternal(endorseCertificate);
+
+  Statement stmt(*this,
+                 "INSERT OR REPLACE INTO CollectEndorseVersion \
+                  (endorser, dns_version) VALUES (?, ?)");
+  sqlite3_bind_string(stmt, 1, endorser.toUri(), SQLITE_TRANSIENT);
+  sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(dnsVersion));
+  executeWrite(stmt);
+
+  transaction.commit();
+}
+
+void
+ContactStorage::getCollectEndorseVersions(std::map<Name, uint64_t>& versions)
+{
+  Statement stmt(*this, "SELECT endorser, dns_version FROM CollectEndorseVersion");
+
+  while (sqlite3_step(stmt) == SQLITE_ROW)
+    versions[Name(sqlite3_column_string(stmt, 0))] =
+      static_cast<uint64_t>(sqlite3_column_int64(stmt, 1));
+}
+
+void
+ContactStorage::updateCollectEndorseInternal(const EndorseCertificate& endorseCertificate)
 {
   Name endorserName = endorseCertificate.getSigner();
   Name certName = endorseCertificate.getName();
 
-  sqlite3_stmt *stmt;
-  sqlite3_prepare_v2(m_db,
-                     "INSERT OR REPLACE INTO CollectEndorse \
-                      (endorser, endorse_name, endorse_data) \
-                      VALUES (?, ?, ?, ?)",
-                     -1, &stmt, 0);
+  Statement stmt(*this,
+                 "INSERT OR REPLACE INTO CollectEndorse \
+                  (endorser, endorse_name, endorse_data, endorse_hash) \
+                  VALUES (?, ?, ?, ?)");
+  const Block& wire = endorseCertificate.wireEncode();
   sqlite3_bind_string(stmt, 1, endorserName.toUri(), SQLITE_TRANSIENT);
   sqlite3_bind_string(stmt, 2, certName.toUri(), SQLITE_TRANSIENT);
-  sqlite3_bind_block(stmt, 3, endorseCertificate.wireEncode(), SQLITE_TRANSIENT);
-  sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
+  sqlite3_bind_block(stmt, 3, wire, SQLITE_TRANSIENT);
+  string hash = computeEndorseHash(wire.wire(), wire.size());
+  sqlite3_bind_blob(stmt, 4, hash.c_str(), hash.size(), SQLITE_TRANSIENT);
+  executeWrite(stmt);
   return;
 }
 
 void
 ContactStorage::getCollectEndorse(EndorseCollection& endorseCollection)
 {
-  sqlite3_stmt *stmt;
-  sqlite3_prepare_v2(m_db, "SELECT endorse_name, endorse_data FROM CollectEndorse", -1, &stmt, 0);
+  Statement stmt(*this, "SELECT endorse_name, endorse_hash FROM CollectEndorse");
 
   while (sqlite3_step(stmt) == SQLITE_ROW) {
     string certName = sqlite3_column_string(stmt, 0);
-    std::stringstream ss;
-    {
-      using namespace CryptoPP;
-      SHA256 hash;
-
-      StringSource(sqlite3_column_text(stmt, 1), sqlite3_column_bytes (stmt, 1), true,
-                   new HashFilter(hash, new FileSink(ss)));
-    }
-    endorseCollection.addCollectionEntry(Name(certName), ss.str());
+    endorseCollection.addCollectionEntry(Name(certName), sqlite3_column_string(stmt, 1));
   }
-
-  sqlite3_finalize(stmt);
 }
 
 void
 ContactStorage::getEndorseList(const Name& identity, vector<string>& endorseList)
 {
-  sqlite3_stmt *stmt;
-  sqlite3_prepare_v2(m_db,
-                     "SELECT profile_type FROM ContactProfile \
-                      WHERE profile_identity=? AND endorse=1 ORDER BY profile_type",
-                     -1, &stmt, 0);
+  Statement stmt(*this,
+                 "SELECT profile_type FROM ContactProfile \
+                  WHERE profile_identity=? AND endorse=1 ORDER BY profile_type");
   sqlite3_bind_string(stmt, 1, identity.toUri(), SQLITE_TRANSIENT);
 
   while (sqlite3_step(stmt) == SQLITE_ROW) {
     string profileType = sqlite3_column_string(stmt, 0);
     endorseList.push_back(profileType);
   }
-  sqlite3_finalize(stmt);
 }
 
 
 void
 ContactStorage::removeContact(const Name& identityName)
+{
+  Transaction transaction(*this);
+  removeContactInternal(identityName);
+  transaction.commit();
+}
+
+void
+ContactStorage::removeContactInternal(const Name& identityName)
 {
   string identity = identityName.toUri();
 
-  sqlite3_stmt *stmt;
-  sqlite3_prepare_v2(m_db, "DELETE FROM Contact WHERE contact_namespace=?", -1, &stmt, 0);
-  sqlite3_bind_string(stmt, 1, identity, SQLITE_TRANSIENT);
-  sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
+  {
+    Statement stmt(*this, "DELETE FROM Contact WHERE contact_namespace=?");
+    sqlite3_bind_string(stmt, 1, identity, SQLITE_TRANSIENT);
+    executeWrite(stmt);
+  }
 
-  sqlite3_prepare_v2(m_db, "DELETE FROM ContactProfile WHERE profile_identity=?", -1, &stmt, 0);
-  sqlite3_bind_string(stmt, 1, identity, SQLITE_TRANSIENT);
-  sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
+  {
+    Statement stmt(*this, "DELETE FROM ContactProfile WHERE profile_identity=?");
+    sqlite3_bind_string(stmt, 1, identity, SQLITE_TRANSIENT);
+    executeWrite(stmt);
+  }
 
-  sqlite3_prepare_v2(m_db, "DELETE FROM TrustScope WHERE contact_namespace=?", -1, &stmt, 0);
-  sqlite3_bind_string(stmt, 1, identity, SQLITE_TRANSIENT);
-  sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
+  {
+    Statement stmt(*this, "DELETE FROM TrustScope WHERE contact_namespace=?");
+    sqlite3_bind_string(stmt, 1, identity, SQLITE_TRANSIENT);
+    executeWrite(stmt);
+  }
 }
 
 void
 ContactStorage::addContact(const Contact& contact)
+{
+  Transaction transaction(*this);
+  addContactInternal(contact);
+  transaction.commit();
+}
+
+void
+ContactStorage::addContacts(const vector<shared_ptr<Contact> >& contacts)
+{
+  Transaction transaction(*this);
+
+  for (vector<shared_ptr<Contact> >::const_iterator it = contacts.begin();
+       it != contacts.end(); it++)
+    addContactInternal(**it);
+
+  transaction.commit();
+}
+
+void
+ContactStorage::addContactInternal(const Contact& contact)
 {
   if (doesContactExist(contact.getNameSpace()))
     throw Error("Normal Contact has already existed");
@@ -364,39 +581,35 @@ ContactStorage::addContact(const Contact& contact)
   string identity = contact.getNameSpace().toUri();
   bool isIntroducer = contact.isIntroducer();
 
-  sqlite3_stmt *stmt;
-  sqlite3_prepare_v2(m_db,
-                     "INSERT INTO Contact (contact_namespace, contact_alias, contact_keyName, \
-                      contact_key, notBefore, notAfter, is_introducer) \
-                      values (?, ?, ?, ?, ?, ?, ?)",
-                     -1, &stmt, 0);
-
-  sqlite3_bind_string(stmt, 1, identity, SQLITE_TRANSIENT);
-  sqlite3_bind_string(stmt, 2, contact.getAlias(), SQLITE_TRANSIENT);
-  sqlite3_bind_string(stmt, 3, contact.getPublicKeyName().toUri(), SQLITE_TRANSIENT);
-  sqlite3_bind_text(stmt, 4,
-                    reinterpret_cast<const char*>(contact.getPublicKey().get().buf()),
-                    contact.getPublicKey().get().size(), SQLITE_TRANSIENT);
-  sqlite3_bind_int64(stmt, 5, time::toUnixTimestamp(contact.getNotBefore()).count());
-  sqlite3_bind_int64(stmt, 6, time::toUnixTimestamp(contact.getNotAfter()).count());
-  sqlite3_bind_int(stmt, 7, (isIntroducer ? 1 : 0));
-
-  sqlite3_step(stmt);
+  {
+    Statement stmt(*this,
+                   "INSERT INTO Contact (contact_namespace, contact_alias, contact_keyName, \
+                    contact_key, notBefore, notAfter, is_introducer) \
+                    values (?, ?, ?, ?, ?, ?, ?)");
 
-  sqlite3_finalize(stmt);
+    sqlite3_bind_string(stmt, 1, identity, SQLITE_TRANSIENT);
+    sqlite3_bind_string(stmt, 2, contact.getAlias(), SQLITE_TRANSIENT);
+    sqlite3_bind_string(stmt, 3, contact.getPublicKeyName().toUri(), SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 4,
+                      reinterpret_cast<const char*>(contact.getPublicKey().get().buf()),
+                      contact.getPublicKey().get().size(), SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 5, time::toUnixTimestamp(contact.getNotBefore()).count());
+    sqlite3_bind_int64(stmt, 6, time::toUnixTimestamp(contact.getNotAfter()).count());
+    sqlite3_bind_int(stmt, 7, (isIntroducer ? 1 : 0));
+
+    executeWrite(stmt);
+  }
 
   const Profile& profile = contact.getProfile();
   for (Profile::const_iterator it = profile.begin(); it != profile.end(); it++) {
-    sqlite3_prepare_v2(m_db,
-                       "INSERT INTO ContactProfile \
-                        (profile_identity, profile_type, profile_value, endorse) \
-                        values (?, ?, ?, 0)",
-                       -1, &stmt, 0);
+    Statement stmt(*this,
+                   "INSERT INTO ContactProfile \
+                    (profile_identity, profile_type, profile_value, endorse) \
+                    values (?, ?, ?, 0)");
     sqlite3_bind_string(stmt, 1, identity, SQLITE_TRANSIENT);
     sqlite3_bind_string(stmt, 2, it->first, SQLITE_TRANSIENT);
     sqlite3_bind_string(stmt, 3, it->second, SQLITE_TRANSIENT);
-    sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    executeWrite(stmt);
   }
 
   if (isIntroducer) {
@@ -404,13 +617,11 @@ ContactStorage::addContact(const Contact& contact)
     Contact::const_iterator end = contact.trustScopeEnd();
 
     while (it != end) {
-      sqlite3_prepare_v2(m_db,
-                         "INSERT INTO TrustScope (contact_namespace, trust_scope) values (?, ?)",
-                         -1, &stmt, 0);
+      Statement stmt(*this,
+                     "INSERT INTO TrustScope (contact_namespace, trust_scope) values (?, ?)");
       sqlite3_bind_string(stmt, 1, identity, SQLITE_TRANSIENT);
       sqlite3_bind_string(stmt, 2, it->first.toUri(), SQLITE_TRANSIENT);
-      sqlite3_step(stmt);
-      sqlite3_finalize(stmt);
+      executeWrite(stmt);
       it++;
     }
   }
@@ -423,53 +634,53 @@ ContactStorage::getContact(const Name& identity) const
   shared_ptr<Contact> contact;
   Profile profile;
 
-  sqlite3_stmt *stmt;
-  sqlite3_prepare_v2(m_db,
-                     "SELECT contact_alias, contact_keyName, contact_key, notBefore, notAfter, \
-                      is_introducer FROM Contact where contact_namespace=?",
-                      -1, &stmt, 0);
-  sqlite3_bind_string(stmt, 1, identity.toUri(), SQLITE_TRANSIENT);
+  {
+    Statement stmt(*this,
+                   "SELECT contact_alias, contact_keyName, contact_key, notBefore, notAfter, \
+                    is_introducer FROM Contact where contact_namespace=?");
+    sqlite3_bind_string(stmt, 1, identity.toUri(), SQLITE_TRANSIENT);
 
-  if (sqlite3_step(stmt) == SQLITE_ROW) {
-    string alias = sqlite3_column_string(stmt, 0);
-    string keyName = sqlite3_column_string(stmt, 1);
-    PublicKey key(sqlite3_column_text(stmt, 2), sqlite3_column_bytes (stmt, 2));
-    time::system_clock::TimePoint notBefore =
-      time::fromUnixTimestamp(time::milliseconds(sqlite3_column_int64 (stmt, 3)));
-    time::system_clock::TimePoint notAfter =
-      time::fromUnixTimestamp(time::milliseconds(sqlite3_column_int64 (stmt, 4)));
-    int isIntroducer = sqlite3_column_int (stmt, 5);
-
-    contact = make_shared<Contact>(identity, alias, Name(keyName),
-                                   notBefore, notAfter, key, isIntroducer);
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+      string alias = sqlite3_column_string(stmt, 0);
+      string keyName = sqlite3_column_string(stmt, 1);
+      PublicKey key(sqlite3_column_text(stmt, 2), sqlite3_column_bytes (stmt, 2));
+      time::system_clock::TimePoint notBefore =
+        time::fromUnixTimestamp(time::milliseconds(sqlite3_column_int64 (stmt, 3)));
+      time::system_clock::TimePoint notAfter =
+        time::fromUnixTimestamp(time::milliseconds(sqlite3_column_int64 (stmt, 4)));
+      int isIntroducer = sqlite3_column_int (stmt, 5);
+
+      contact = make_shared<Contact>(identity, alias, Name(keyName),
+                                     notBefore, notAfter, key, isIntroducer);
+    }
   }
-  sqlite3_finalize(stmt);
 
-  sqlite3_prepare_v2(m_db,
-                     "SELECT profile_type, profile_value FROM ContactProfile \
-                      where profile_identity=?",
-                     -1, &stmt, 0);
-  sqlite3_bind_string(stmt, 1, identity.toUri(), SQLITE_TRANSIENT);
+  {
+    Statement stmt(*this,
+                   "SELECT profile_type, profile_value FROM ContactProfile \
+                    where profile_identity=?");
+    sqlite3_bind_string(stmt, 1, identity.toUri(), SQLITE_TRANSIENT);
 
-  while (sqlite3_step(stmt) == SQLITE_ROW) {
-    string type = sqlite3_column_string(stmt, 0);
-    string value = sqlite3_column_string(stmt, 1);
-    profile[type] = value;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      string type = sqlite3_column_string(stmt, 0);
+      string value = sqlite3_column_string(stmt, 1);
+      profile[type] = value;
+    }
   }
-  sqlite3_finalize(stmt);
+
+  if (!static_cast<bool>(contact))
+    return contact;
+
   contact->setProfile(profile);
 
   if (contact->isIntroducer()) {
-    sqlite3_prepare_v2(m_db,
-                       "SELECT trust_scope FROM TrustScope WHERE contact_namespace=?",
-                       -1, &stmt, 0);
+    Statement stmt(*this, "SELECT trust_scope FROM TrustScope WHERE contact_namespace=?");
     sqlite3_bind_string(stmt, 1, identity.toUri(), SQLITE_TRANSIENT);
 
     while (sqlite3_step(stmt) == SQLITE_ROW) {
       Name scope(sqlite3_column_string(stmt, 0));
       contact->addTrustScope(scope);
     }
-    sqlite3_finalize(stmt);
   }
 
   return contact;
@@ -479,26 +690,20 @@ ContactStorage::getContact(const Name& identity) const
 void
 ContactStorage::updateIsIntroducer(const Name& identity, bool isIntroducer)
 {
-  sqlite3_stmt *stmt;
-  sqlite3_prepare_v2(m_db, "UPDATE Contact SET is_introducer=? WHERE contact_namespace=?",
-                     -1, &stmt, 0);
+  Statement stmt(*this, "UPDATE Contact SET is_introducer=? WHERE contact_namespace=?");
   sqlite3_bind_int(stmt, 1, (isIntroducer ? 1 : 0));
   sqlite3_bind_string(stmt, 2, identity.toUri(), SQLITE_TRANSIENT);
   sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
   return;
 }
 
 void
 ContactStorage::updateAlias(const Name& identity, const string& alias)
 {
-  sqlite3_stmt *stmt;
-  sqlite3_prepare_v2(m_db, "UPDATE Contact SET contact_alias=? WHERE contact_namespace=?",
-                     -1, &stmt, 0);
+  Statement stmt(*this, "UPDATE Contact SET contact_alias=? WHERE contact_namespace=?");
   sqlite3_bind_string(stmt, 1, alias, SQLITE_TRANSIENT);
   sqlite3_bind_string(stmt, 2, identity.toUri(), SQLITE_TRANSIENT);
   sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
   return;
 }
 
@@ -507,8 +712,7 @@ ContactStorage::doesContactExist(const Name& name)
 {
   bool result = false;
 
-  sqlite3_stmt *stmt;
-  sqlite3_prepare_v2(m_db, "SELECT count(*) FROM Contact WHERE contact_namespace=?", -1, &stmt, 0);
+  Statement stmt(*this, "SELECT count(*) FROM Contact WHERE contact_namespace=?");
   sqlite3_bind_string(stmt, 1, name.toUri(), SQLITE_TRANSIENT);
 
   int res = sqlite3_step(stmt);
@@ -519,47 +723,101 @@ ContactStorage::doesContactExist(const Name& name)
       result = true;
   }
 
-  sqlite3_finalize(stmt);
   return result;
 }
 
 void
 ContactStorage::getAllContacts(vector<shared_ptr<Contact> >& contacts) const
 {
-  vector<Name> contactNames;
+  // Three scans ordered by namespace, merged against the contact list in one pass,
+  // instead of three lookups per contact.
+  vector<string> identities;
+  vector<shared_ptr<Contact> > loaded;
+  vector<Profile> profiles;
 
-  sqlite3_stmt *stmt;
-  sqlite3_prepare_v2(m_db, "SELECT contact_namespace FROM Contact", -1, &stmt, 0);
+  {
+    Statement stmt(*this,
+                   "SELECT contact_namespace, contact_alias, contact_keyName, contact_key, \
+                    notBefore, notAfter, is_introducer FROM Contact \
+                    ORDER BY contact_namespace");
 
-  while (sqlite3_step(stmt) == SQLITE_ROW) {
-    string identity = sqlite3_column_string(stmt, 0);
-    contactNames.push_back(Name(identity));
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      string identity = sqlite3_column_string(stmt, 0);
+      string alias = sqlite3_column_string(stmt, 1);
+      string keyName = sqlite3_column_string(stmt, 2);
+      PublicKey key(sqlite3_column_text(stmt, 3), sqlite3_column_bytes (stmt, 3));
+      time::system_clock::TimePoint notBefore =
+        time::fromUnixTimestamp(time::milliseconds(sqlite3_column_int64 (stmt, 4)));
+      time::system_clock::TimePoint notAfter =
+        time::fromUnixTimestamp(time::milliseconds(sqlite3_column_int64 (stmt, 5)));
+      int isIntroducer = sqlite3_column_int (stmt, 6);
+
+      identities.push_back(identity);
+      loaded.push_back(make_shared<Contact>(Name(identity), alias, Name(keyName),
+                                            notBefore, notAfter, key, isIntroducer));
+    }
   }
-  sqlite3_finalize(stmt);
 
-  for (vector<Name>::iterator it = contactNames.begin(); it != contactNames.end(); it++) {
-    shared_ptr<Contact> contact = getContact(*it);
-    if (static_cast<bool>(contact))
-      contacts.push_back(contact);
+  profiles.resize(loaded.size());
+
+  {
+    Statement stmt(*this,
+                   "SELECT profile_identity, profile_type, profile_value FROM ContactProfile \
+                    ORDER BY profile_identity");
+
+    size_t i = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      string identity = sqlite3_column_string(stmt, 0);
+      while (i < identities.size() && identities[i] < identity)
+        i++;
+      if (i == identities.size())
+        break;
+      if (identities[i] != identity)
+        continue;
+
+      string type = sqlite3_column_string(stmt, 1);
+      string value = sqlite3_column_string(stmt, 2);
+      profiles[i][type] = value;
+    }
+  }
+
+  for (size_t i = 0; i < loaded.size(); i++)
+    loaded[i]->setProfile(profiles[i]);
+
+  {
+    Statement stmt(*this,
+                   "SELECT contact_namespace, trust_scope FROM TrustScope \
+                    ORDER BY contact_namespace, id");
+
+    size_t i = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      string identity = sqlite3_column_string(stmt, 0);
+      while (i < identities.size() && identities[i] < identity)
+        i++;
+      if (i == identities.size())
+        break;
+      if (identities[i] != identity || !loaded[i]->isIntroducer())
+        continue;
+
+      loaded[i]->addTrustScope(Name(sqlite3_column_string(stmt, 1)));
+    }
   }
+
+  contacts.insert(contacts.end(), loaded.begin(), loaded.end());
 }
 
 void
 ContactStorage::updateDnsData(const Block& data, const string& name,
                               const string& type, const string& dataName)
 {
-  sqlite3_stmt *stmt;
-  sqlite3_prepare_v2(m_db,
-                     "INSERT OR REPLACE INTO DnsData (dns_name, dns_type, dns_value, data_name) \
-                      VALUES (?, ?, ?, ?)",
-                     -1, &stmt, 0);
+  Statement stmt(*this,
+                 "INSERT OR REPLACE INTO DnsData (dns_name, dns_type, dns_value, data_name) \
+                  VALUES (?, ?, ?, ?)");
   sqlite3_bind_string(stmt, 1, name, SQLITE_TRANSIENT);
   sqlite3_bind_string(stmt, 2, type, SQLITE_TRANSIENT);
   sqlite3_bind_block(stmt, 3, data, SQLITE_TRANSIENT);
   sqlite3_bind_string(stmt, 4, dataName, SQLITE_TRANSIENT);
   sqlite3_step(stmt);
-
-  sqlite3_finalize(stmt);
 }
 
 shared_ptr<Data>
@@ -567,15 +825,13 @@ ContactStorage::getDnsData(const Name& dataName)
 {
   shared_ptr<Data> data;
 
-  sqlite3_stmt *stmt;
-  sqlite3_prepare_v2(m_db, "SELECT dns_value FROM DnsData where data_name=?", -1, &stmt, 0);
+  Statement stmt(*this, "SELECT dns_value FROM DnsData where data_name=?");
   sqlite3_bind_string(stmt, 1, dataName.toUri(), SQLITE_TRANSIENT);
 
   if (sqlite3_step(stmt) == SQLITE_ROW) {
     data = make_shared<Data>();
     data->wireDecode(sqlite3_column_block(stmt, 0));
   }
-  sqlite3_finalize(stmt);
 
   return data;
 }
@@ -585,9 +841,7 @@ ContactStorage::getDnsData(const string& name, const string& type)
 {
   shared_ptr<Data> data;
 
-  sqlite3_stmt *stmt;
-  sqlite3_prepare_v2(m_db, "SELECT dns_value FROM DnsData where dns_name=? and dns_type=?",
-                     -1, &stmt, 0);
+  Statement stmt(*this, "SELECT dns_value FROM DnsData where dns_name=? and dns_type=?");
   sqlite3_bind_string(stmt, 1, name, SQLITE_TRANSIENT);
   sqlite3_bind_string(stmt, 2, type, SQLITE_TRANSIENT);
 
@@ -595,7 +849,6 @@ ContactStorage::getDnsData(const string& name, const string& type)
     data = make_shared<Data>();
     data->wireDecode(sqlite3_column_block(stmt, 0));
   }
-  sqlite3_finalize(stmt);
 
   return data;
 }
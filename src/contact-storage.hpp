@@ -33,10 +33,17 @@ public:
 
   ContactStorage(const Name& identity);
 
-  ~ContactStorage()
-  {
-    sqlite3_close(m_db);
-  }
+  ~ContactStorage();
+
+  /**
+   * @brief PRAGMAs applied to every connection to the contact DB
+   *
+   * The DB is in WAL mode, so readers (e.g., the GUI table models) see a consistent
+   * snapshot and are neither blocked by nor block the backend writer.  The busy timeout
+   * is not part of it, each connection sets its own.
+   */
+  static const std::vector<std::string>&
+  getStorageProfile();
 
   shared_ptr<Profile>
   getSelfProfile();
@@ -50,9 +57,25 @@ public:
   void
   updateCollectEndorse(const EndorseCertificate& endorseCertificate);
 
+  /// @brief Store a batch of collected endorsements in a single transaction
+  void
+  updateCollectEndorse(const std::vector<shared_ptr<EndorseCertificate> >& endorseCertificates);
+
+  /**
+   * @brief Store an endorsement collected from @p endorser, together with the version of
+   *        the ENDORSEE record it was taken from
+   */
+  void
+  updateCollectEndorse(const EndorseCertificate& endorseCertificate,
+                       const Name& endorser, uint64_t dnsVersion);
+
   void
   getCollectEndorse(EndorseCollection& endorseCollection);
 
+  /// @brief Get the version of the last ENDORSEE record collected from each endorser
+  void
+  getCollectEndorseVersions(std::map<Name, uint64_t>& versions);
+
   void
   getEndorseList(const Name& identity, std::vector<std::string>& endorseList);
 
@@ -62,6 +85,14 @@ public:
   void
   addContact(const Contact& contact);
 
+  /**
+   * @brief Add a batch of contacts in a single transaction
+   *
+   * @throws Error if any of the contacts already exists; nothing is added in that case.
+   */
+  void
+  addContacts(const std::vector<shared_ptr<Contact> >& contacts);
+
   shared_ptr<Contact>
   getContact(const Name& identity) const;
 
@@ -99,15 +130,89 @@ public:
   getDnsData(const std::string& name, const std::string& type);
 
 private:
+  /**
+   * @brief A statement borrowed from the prepared-statement cache
+   *
+   * The statement is prepared on first use and kept by ContactStorage.  It is reset and
+   * its bindings are cleared when the borrower goes out of scope, so that no read
+   * transaction stays open between calls.
+   */
+  class Statement : noncopyable
+  {
+  public:
+    Statement(const ContactStorage& storage, const std::string& sql);
+
+    ~Statement();
+
+    operator sqlite3_stmt*() const
+    {
+      return m_stmt;
+    }
+
+  private:
+    sqlite3_stmt* m_stmt;
+  };
+
+  /**
+   * @brief An explicit transaction, rolled back unless commit() is called
+   *
+   * Grouping the statements of one logical write lets SQLite sync the journal once
+   * instead of once per statement.
+   */
+  class Transaction : noncopyable
+  {
+  public:
+    explicit
+    Transaction(const ContactStorage& storage);
+
+    ~Transaction();
+
+    void
+    commit();
+
+  private:
+    const ContactStorage& m_storage;
+    bool m_isCommitted;
+  };
+
+  typedef std::map<std::string, sqlite3_stmt*> StatementCache;
+
+  sqlite3_stmt*
+  getCachedStatement(const std::string& sql) const;
+
+  /**
+   * @brief Execute @p stmt, which returns no row
+   *
+   * @throw Error the statement failed, so that the enclosing Transaction is rolled back
+   */
+  void
+  executeWrite(sqlite3_stmt* stmt) const;
+
   std::string
   getDBName();
 
+  void
+  applyStorageProfile();
+
   void
   initializeTable(const std::string& tableName, const std::string& sqlCreateStmt);
 
+  /// @brief Add and fill the endorse_hash column of a CollectEndorse table that lacks it
+  void
+  upgradeCollectEndorseTable();
+
   bool
   doesContactExist(const Name& name);
 
+  void
+  addContactInternal(const Contact& contact);
+
+  void
+  removeContactInternal(const Name& identity);
+
+  void
+  updateCollectEndorseInternal(const EndorseCertificate& endorseCertificate);
+
   void
   updateDnsData(const Block& data,
                 const std::string& name,
@@ -118,6 +223,7 @@ private:
   Name m_identity;
 
   sqlite3 *m_db;
+  mutable StatementCache m_statements;
 };
 
 } // namespace chronochat
@@ -108,6 +108,12 @@ public:
     return m_alias;
   }
 
+  void
+  setAlias(const std::string& alias)
+  {
+    m_alias = alias;
+  }
+
   const std::string&
   getName() const
   {
@@ -14,6 +14,7 @@
 #ifndef Q_MOC_RUN
 #include <ndn-cxx/util/segment-fetcher.hpp>
 #include "invitation.hpp"
+#include "signing-service.hpp"
 #include "logging.h"
 #endif
 
@@ -45,13 +46,18 @@ ControllerBackend::ControllerBackend(QObject* parent)
   connect(this, SIGNAL(identityUpdated(const QString&)),
           &m_contactManager, SLOT(onIdentityUpdated(const QString&)));
 
-  connect(&m_contactManager, SIGNAL(contactIdListReady(const QStringList&)),
-          this, SLOT(onContactIdListReady(const QStringList&)));
+  connect(&m_contactManager, SIGNAL(contactListReady(const QStringList&, const QStringList&)),
+          this, SLOT(onContactListReady(const QStringList&, const QStringList&)));
+  connect(&m_contactManager, SIGNAL(contactAdded(const QString&, const QString&)),
+          this, SLOT(onContactAdded(const QString&)));
+  connect(&m_contactManager, SIGNAL(contactRemoved(const QString&, const QString&)),
+          this, SLOT(onContactRemoved(const QString&, const QString&)));
 
 }
 
 ControllerBackend::~ControllerBackend()
 {
+  SigningService::getDefault().cancel(m_face.getIoService());
 }
 
 void
@@ -400,7 +406,12 @@ ControllerBackend::onIdentityChanged(const QString& identity)
 
   std::cerr << "ControllerBackend::onIdentityChanged: " << m_identity << std::endl;
 
-  m_keyChain.createIdentity(m_identity);
+  // queued before anything signed by the new identity
+  Name newIdentity = m_identity;
+  SigningService::getDefault().query<Name>(
+    [newIdentity] (ndn::KeyChain& keyChain) { return keyChain.createIdentity(newIdentity); },
+    m_face.getIoService(), function<void(const Name&)>(),
+    bind(&ControllerBackend::onSigningFailed, this, _1));
 
   setInvitationListener();
 
@@ -409,22 +420,33 @@ ControllerBackend::onIdentityChanged(const QString& identity)
 
 void
 ControllerBackend::onInvitationResponded(const ndn::Name& invitationName, bool accepted)
+{
+  if (accepted) {
+    // We should create a particular certificate for this chatroom,
+    //but let's use default one for now.
+    SigningService::getDefault().getCertificate(m_identity, m_face.getIoService(),
+      bind(&ControllerBackend::replyInvitation, this, invitationName, _1),
+      bind(&ControllerBackend::onSigningFailed, this, _1));
+  }
+  else
+    replyInvitation(invitationName, shared_ptr<IdentityCertificate>());
+
+  Invitation invitation(invitationName);
+  emit startChatroomOnInvitation(invitation, true);
+}
+
+void
+ControllerBackend::replyInvitation(const Name& invitationName,
+                                   const shared_ptr<IdentityCertificate>& chatroomCert)
 {
   shared_ptr<Data> response = make_shared<Data>();
-  shared_ptr<IdentityCertificate> chatroomCert;
 
   // generate reply;
-  if (accepted) {
+  if (static_cast<bool>(chatroomCert)) {
     Name responseName = invitationName;
     responseName.append(m_localPrefix.wireEncode());
 
     response->setName(responseName);
-
-    // We should create a particular certificate for this chatroom,
-    //but let's use default one for now.
-    chatroomCert
-      = m_keyChain.getCertificate(m_keyChain.getDefaultCertificateNameForIdentity(m_identity));
-
     response->setContent(chatroomCert->wireEncode());
     response->setFreshnessPeriod(time::milliseconds(1000));
   }
@@ -433,8 +455,14 @@ ControllerBackend::onInvitationResponded(const ndn::Name& invitationName, bool a
     response->setFreshnessPeriod(time::milliseconds(1000));
   }
 
-  m_keyChain.signByIdentity(*response, m_identity);
+  SigningService::getDefault().sign(response, m_identity, m_face.getIoService(),
+    bind(&ControllerBackend::putInvitationResponse, this, response),
+    bind(&ControllerBackend::onSigningFailed, this, _1));
+}
 
+void
+ControllerBackend::putInvitationResponse(const shared_ptr<Data>& response)
+{
   // Check if we need a wrapper
   Name invitationRoutingPrefix = getInvitationRoutingPrefix();
   if (invitationRoutingPrefix.isPrefixOf(m_identity))
@@ -451,12 +479,17 @@ ControllerBackend::onInvitationResponded(const ndn::Name& invitationName, bool a
     wrappedData->setContent(response->wireEncode());
     wrappedData->setFreshnessPeriod(time::milliseconds(1000));
 
-    m_keyChain.signByIdentity(*wrappedData, m_identity);
-    m_face.put(*wrappedData);
+    SigningService::getDefault().sign(wrappedData, m_identity, m_face.getIoService(),
+      [this, wrappedData] { m_face.put(*wrappedData); },
+      bind(&ControllerBackend::onSigningFailed, this, _1));
   }
+}
 
-  Invitation invitation(invitationName);
-  emit startChatroomOnInvitation(invitation, true);
+void
+ControllerBackend::onSigningFailed(const string& failInfo)
+{
+  std::cerr << "ControllerBackend: cannot sign with " << m_identity << ": " << failInfo
+            << std::endl;
 }
 
 void
@@ -469,9 +502,12 @@ ControllerBackend::onInvitationRequestResponded(const ndn::Name& invitationRespo
   else
     response->setContent(ndn::makeNonNegativeIntegerBlock(tlv::Content, 0));
 
-  m_keyChain.signByIdentity(*response, m_identity);
-  m_ims.insert(*response);
-  m_face.put(*response);
+  SigningService::getDefault().sign(response, m_identity, m_face.getIoService(),
+    [this, response] {
+      m_ims.insert(*response);
+      m_face.put(*response);
+    },
+    bind(&ControllerBackend::onSigningFailed, this, _1));
 }
 
 void
@@ -495,7 +531,7 @@ ControllerBackend::onSendInvitationRequest(const QString& chatroomName, const QS
 }
 
 void
-ControllerBackend::onContactIdListReady(const QStringList& list)
+ControllerBackend::onContactListReady(const QStringList& idList, const QStringList& aliasList)
 {
   ContactList contactList;
 
@@ -507,6 +543,21 @@ ControllerBackend::onContactIdListReady(const QStringList& list)
 
 }
 
+void
+ControllerBackend::onContactAdded(const QString& identity)
+{
+  // the contact may have been removed again before this slot runs
+  shared_ptr<Contact> contact = m_contactManager.getContact(Name(identity.toStdString()));
+  if (static_cast<bool>(contact))
+    m_validator.addTrustAnchor(contact->getPublicKeyName(), contact->getPublicKey());
+}
+
+void
+ControllerBackend::onContactRemoved(const QString& identity, const QString& keyName)
+{
+  m_validator.removeTrustAnchor(Name(keyName.toStdString()));
+}
+
 void
 ControllerBackend::onNfdReconnect()
 {
@@ -21,7 +21,6 @@
 #include "contact-manager.hpp"
 #include "invitation.hpp"
 #include "validator-invitation.hpp"
-#include <ndn-cxx/security/key-chain.hpp>
 #include <ndn-cxx/util/in-memory-storage-persistent.hpp>
 #include <ndn-cxx/security/validator-null.hpp>
 #include <boost/thread.hpp>
@@ -89,6 +88,17 @@ private:
   void
   updateLocalPrefix(const Name& localPrefix);
 
+  /// @brief Sign and send the response to an invitation, accepted if @p chatroomCert is set
+  void
+  replyInvitation(const Name& invitationName,
+                  const shared_ptr<ndn::IdentityCertificate>& chatroomCert);
+
+  void
+  putInvitationResponse(const shared_ptr<Data>& response);
+
+  void
+  onSigningFailed(const std::string& failInfo);
+
   void
   onRequestResponse(const Interest& interest, Data& data);
 
@@ -150,7 +160,13 @@ public slots:
 
 private slots:
   void
-  onContactIdListReady(const QStringList& list);
+  onContactListReady(const QStringList& idList, const QStringList& aliasList);
+
+  void
+  onContactAdded(const QString& identity);
+
+  void
+  onContactRemoved(const QString& identity, const QString& keyName);
 
 private:
   bool m_isNfdConnected;
@@ -165,7 +181,6 @@ private:
   ContactManager m_contactManager;
 
   // Security related;
-  ndn::KeyChain m_keyChain;
   ValidatorInvitation m_validator;
   ndn::ValidatorNull m_nullValidator;
 
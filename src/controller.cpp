@@ -13,6 +13,7 @@
 #include <QMessageBox>
 #include <QDir>
 #include <QTimer>
+#include <QtSql/QSqlQuery>
 #include "controller.hpp"
 
 #ifndef Q_MOC_RUN
@@ -23,6 +24,8 @@
 #include "logging.h"
 #include "conf.hpp"
 #include "endorse-info.hpp"
+#include "contact-storage.hpp"
+#include "signing-service.hpp"
 #endif
 
 INIT_LOGGER("chronochat.Controller");
@@ -41,6 +44,8 @@ namespace chronochat {
 
 using std::string;
 
+static const int DB_BUSY_TIMEOUT_MS = 100;
+
 // constructor & destructor
 Controller::Controller(QWidget* parent)
   : QDialog(parent)
@@ -126,6 +131,8 @@ Controller::Controller(QWidget* parent)
           m_browseContactDialog, SLOT(onIdCertNameListReady(const QStringList&)));
   connect(m_backend.getContactManager(), SIGNAL(nameListReady(const QStringList&)),
           m_browseContactDialog, SLOT(onNameListReady(const QStringList&)));
+  connect(m_backend.getContactManager(), SIGNAL(idCertAdded(const QString&, const QString&)),
+          m_browseContactDialog, SLOT(onIdCertAdded(const QString&, const QString&)));
   connect(m_backend.getContactManager(), SIGNAL(idCertReady(const ndn::IdentityCertificate&)),
           m_browseContactDialog, SLOT(onIdCertReady(const ndn::IdentityCertificate&)));
 
@@ -140,6 +147,8 @@ Controller::Controller(QWidget* parent)
           m_backend.getContactManager(), SLOT(onUpdateAlias(const QString&, const QString&)));
   connect(m_contactPanel, SIGNAL(updateIsIntroducer(const QString&, bool)),
           m_backend.getContactManager(), SLOT(onUpdateIsIntroducer(const QString&, bool)));
+  connect(m_contactPanel, SIGNAL(updateTrustScope(const QString&)),
+          m_backend.getContactManager(), SLOT(onUpdateTrustScope(const QString&)));
   connect(m_contactPanel, SIGNAL(updateEndorseCertificate(const QString&)),
           m_backend.getContactManager(), SLOT(onUpdateEndorseCertificate(const QString&)));
   connect(m_contactPanel, SIGNAL(warning(const QString&)),
@@ -148,10 +157,16 @@ Controller::Controller(QWidget* parent)
           m_contactPanel, SLOT(onCloseDBModule()));
   connect(this, SIGNAL(identityUpdated(const QString&)),
           m_contactPanel, SLOT(onIdentityUpdated(const QString&)));
-  connect(m_backend.getContactManager(), SIGNAL(contactAliasListReady(const QStringList&)),
-          m_contactPanel, SLOT(onContactAliasListReady(const QStringList&)));
-  connect(m_backend.getContactManager(), SIGNAL(contactIdListReady(const QStringList&)),
-          m_contactPanel, SLOT(onContactIdListReady(const QStringList&)));
+  connect(m_backend.getContactManager(),
+          SIGNAL(contactListReady(const QStringList&, const QStringList&)),
+          m_contactPanel, SLOT(onContactListReady(const QStringList&, const QStringList&)));
+  connect(m_backend.getContactManager(), SIGNAL(contactAdded(const QString&, const QString&)),
+          m_contactPanel, SLOT(onContactAdded(const QString&, const QString&)));
+  connect(m_backend.getContactManager(), SIGNAL(contactRemoved(const QString&, const QString&)),
+          m_contactPanel, SLOT(onContactRemoved(const QString&)));
+  connect(m_backend.getContactManager(),
+          SIGNAL(contactAliasChanged(const QString&, const QString&)),
+          m_contactPanel, SLOT(onContactAliasChanged(const QString&, const QString&)));
   connect(m_backend.getContactManager(), SIGNAL(contactInfoReady(const QString&, const QString&,
                                                                  const QString&, bool)),
           m_contactPanel, SLOT(onContactInfoReady(const QString&, const QString&,
@@ -233,8 +248,8 @@ Controller::Controller(QWidget* parent)
           m_discoveryPanel, SLOT(onChatroomListReady(const QStringList&)));
   connect(m_chatroomDiscoveryBackend, SIGNAL(chatroomInfoReady(const ChatroomInfo&, bool)),
           m_discoveryPanel, SLOT(onChatroomInfoReady(const ChatroomInfo&, bool)));
-  connect(m_discoveryPanel, SIGNAL(startChatroom(const QString&, bool)),
-          this, SLOT(onStartChatroom(const QString&, bool)));
+  connect(m_discoveryPanel, SIGNAL(joinChatroom(const QString&, bool, const QStringList&)),
+          this, SLOT(onJoinChatroom(const QString&, bool, const QStringList&)));
   connect(m_discoveryPanel, SIGNAL(sendInvitationRequest(const QString&, const QString&)),
           &m_backend, SLOT(onSendInvitationRequest(const QString&, const QString&)));
   connect(&m_backend, SIGNAL(invitationRequestResult(const std::string&)),
@@ -285,7 +300,14 @@ Controller::openDB()
     .append(getDBName().c_str());
   m_db.setDatabaseName(path);
 
-  m_db.open();
+  if (m_db.open()) {
+    // the GUI thread must not freeze while the storage worker holds the DB
+    QSqlQuery(m_db).exec(QString("PRAGMA busy_timeout=%1").arg(DB_BUSY_TIMEOUT_MS));
+
+    const std::vector<string>& profile = ContactStorage::getStorageProfile();
+    for (std::vector<string>::const_iterator it = profile.begin(); it != profile.end(); it++)
+      QSqlQuery(m_db).exec(QString(it->c_str()));
+  }
 
   // bool ok = m_db.open();
   // _LOG_DEBUG("DB opened: " << std::boolalpha << ok );
@@ -324,8 +346,9 @@ Controller::loadConf()
   }
   catch (tlv::Error) {
     try {
-      ndn::KeyChain keyChain;
-      m_identity = keyChain.getDefaultIdentity();
+      m_identity = SigningService::getDefault().call<Name>([] (ndn::KeyChain& keyChain) {
+          return keyChain.getDefaultIdentity();
+        });
     }
     catch (ndn::KeyChain::Error) {
       m_identity.clear();
@@ -751,6 +774,22 @@ Controller::onStartChatroom2(chronochat::Invitation invitation, bool secured)
   it->second->addSyncAnchor(invitation);
 }
 
+void
+Controller::onJoinChatroom(const QString& chatroom, bool secured, const QStringList& roster)
+{
+  onStartChatroom(chatroom, secured);
+
+  ChatDialogList::iterator it = m_chatDialogList.find(chatroom.toStdString());
+  if (it == m_chatDialogList.end())
+    return;
+
+  // members known from discovery are verified before they are heard from
+  std::vector<Name> identities;
+  for (const auto& identity : roster)
+    identities.push_back(Name(identity.toStdString()));
+  it->second->getBackend()->prefetchCertificates(identities);
+}
+
 
 void
 Controller::onShowChatMessage(const QString& chatroomName, const QString& from, const QString& data)
@@ -178,6 +178,9 @@ private slots:
   void
   onStartChatroom2(chronochat::Invitation invitation, bool secured);
 
+  void
+  onJoinChatroom(const QString& chatroom, bool secured, const QStringList& roster);
+
   void
   onShowChatMessage(const QString& chatroomName, const QString& from, const QString& data);
 
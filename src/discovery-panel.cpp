@@ -213,7 +213,7 @@ DiscoveryPanel::onSelectedParticipantChanged(const QItemSelection &selected,
 void
 DiscoveryPanel::onJoinClicked()
 {
-  emit startChatroom(m_chatroom, false);
+  emit joinChatroom(m_chatroom, false, m_rosterList);
 }
 
 void
@@ -68,9 +68,10 @@ signals:
    *
    * @param chatroomName the chatroom to join
    * @param secured if security is enabled in this chatroom
+   * @param roster the identities of the participants of the chatroom
    */
   void
-  startChatroom(const QString& chatroomName, bool secured);
+  joinChatroom(const QString& chatroomName, bool secured, const QStringList& roster);
 
   /**
    * @brief send request for invitation to a chatroom
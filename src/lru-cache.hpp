@@ -0,0 +1,126 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#ifndef CHRONOCHAT_LRU_CACHE_HPP
+#define CHRONOCHAT_LRU_CACHE_HPP
+
+#include "common.hpp"
+
+namespace chronochat {
+
+/**
+ * @brief A map bounded in size and in the age of its entries
+ *
+ * An entry expires @p ttl after it was inserted.  When the cache is full, inserting a new
+ * key evicts the least recently used entry.  The cache is not thread-safe.
+ */
+template<class Key, class Value>
+class LruCache : noncopyable
+{
+public:
+  LruCache(size_t capacity, const time::nanoseconds& ttl)
+    : m_capacity(capacity > 0 ? capacity : 1)
+    , m_ttl(ttl)
+  {
+  }
+
+  /**
+   * @brief Look up @p key and mark it as recently used
+   *
+   * @return the value, valid until the entry is erased or evicted, or 0 if the key is
+   *         absent or expired
+   */
+  Value*
+  find(const Key& key)
+  {
+    typename Entries::iterator it = m_entries.find(key);
+    if (it == m_entries.end())
+      return 0;
+
+    if (it->second.expiry <= time::steady_clock::now()) {
+      m_recency.erase(it->second.position);
+      m_entries.erase(it);
+      return 0;
+    }
+
+    m_recency.splice(m_recency.begin(), m_recency, it->second.position);
+    return &it->second.value;
+  }
+
+  /// @brief Insert or replace the value of @p key, which expires after the TTL from now
+  Value&
+  insert(const Key& key, const Value& value)
+  {
+    typename Entries::iterator it = m_entries.find(key);
+    if (it != m_entries.end()) {
+      m_recency.splice(m_recency.begin(), m_recency, it->second.position);
+    }
+    else {
+      if (m_entries.size() >= m_capacity) {
+        m_entries.erase(m_recency.back());
+        m_recency.pop_back();
+      }
+      m_recency.push_front(key);
+      it = m_entries.insert(std::make_pair(key, Entry())).first;
+      it->second.position = m_recency.begin();
+    }
+
+    it->second.value = value;
+    it->second.expiry = time::steady_clock::now() + m_ttl;
+    return it->second.value;
+  }
+
+  void
+  erase(const Key& key)
+  {
+    typename Entries::iterator it = m_entries.find(key);
+    if (it == m_entries.end())
+      return;
+
+    m_recency.erase(it->second.position);
+    m_entries.erase(it);
+  }
+
+  void
+  clear()
+  {
+    m_entries.clear();
+    m_recency.clear();
+  }
+
+  /// @return the number of entries, including expired ones not yet removed
+  size_t
+  size() const
+  {
+    return m_entries.size();
+  }
+
+private:
+  // most recently used first
+  typedef std::list<Key> Recency;
+
+  struct Entry
+  {
+    Value value;
+    time::steady_clock::TimePoint expiry;
+    typename Recency::iterator position;
+  };
+
+  typedef std::map<Key, Entry> Entries;
+
+  size_t m_capacity;
+  time::nanoseconds m_ttl;
+  Entries m_entries;
+  Recency m_recency;
+};
+
+} // namespace chronochat
+
+#endif // CHRONOCHAT_LRU_CACHE_HPP
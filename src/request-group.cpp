@@ -0,0 +1,170 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#include "request-group.hpp"
+
+namespace chronochat {
+
+RequestGroup::Completion::Completion(RequestGroup& group, uint64_t round)
+  : m_group(&group)
+  , m_round(round)
+  , m_isCalled(make_shared<bool>(false))
+{
+}
+
+void
+RequestGroup::Completion::operator()() const
+{
+  if (*m_isCalled)
+    return;
+  *m_isCalled = true;
+  m_group->onCompleted(m_round);
+}
+
+bool
+RequestGroup::Completion::isCurrent() const
+{
+  return m_group->m_isRunning && m_group->m_round == m_round;
+}
+
+RequestGroup::RequestGroup(boost::asio::io_service& ioService, size_t limit)
+  : m_deadline(ioService)
+  , m_limit(limit > 0 ? limit : 1)
+  , m_round(0)
+  , m_isRunning(false)
+  , m_isClosed(false)
+  , m_isFilling(false)
+  , m_nPending(0)
+  , m_nDone(0)
+  , m_nTotal(0)
+{
+}
+
+void
+RequestGroup::setLimit(size_t limit)
+{
+  m_limit = (limit > 0 ? limit : 1);
+  fill();
+}
+
+void
+RequestGroup::start(const OnProgress& onProgress, const OnDone& onDone,
+                    const boost::posix_time::time_duration& deadline)
+{
+  cancel();
+
+  m_isRunning = true;
+  m_onProgress = onProgress;
+  m_onDone = onDone;
+
+  if (!deadline.is_special()) {
+    m_deadline.expires_from_now(deadline);
+    m_deadline.async_wait(bind(&RequestGroup::onDeadline, this, _1, m_round));
+  }
+}
+
+void
+RequestGroup::add(const Request& request)
+{
+  if (!m_isRunning || m_isClosed)
+    return;
+
+  m_queue.push_back(request);
+  m_nTotal++;
+  fill();
+}
+
+void
+RequestGroup::close()
+{
+  if (!m_isRunning)
+    return;
+
+  m_isClosed = true;
+  finishIfDone();
+}
+
+void
+RequestGroup::cancel()
+{
+  m_round++;
+  m_isRunning = false;
+  m_isClosed = false;
+  m_queue.clear();
+  m_nPending = 0;
+  m_nDone = 0;
+  m_nTotal = 0;
+  m_onProgress = OnProgress();
+  m_onDone = OnDone();
+
+  boost::system::error_code error;
+  m_deadline.cancel(error);
+}
+
+void
+RequestGroup::fill()
+{
+  // requests may complete synchronously, the outermost call keeps starting them
+  if (m_isFilling)
+    return;
+
+  m_isFilling = true;
+  while (m_isRunning && m_nPending < m_limit && !m_queue.empty()) {
+    Request request = m_queue.front();
+    m_queue.pop_front();
+    m_nPending++;
+    request(Completion(*this, m_round));
+  }
+  m_isFilling = false;
+
+  finishIfDone();
+}
+
+void
+RequestGroup::onCompleted(uint64_t round)
+{
+  if (!m_isRunning || round != m_round)
+    return;
+
+  m_nPending--;
+  m_nDone++;
+  if (m_onProgress)
+    m_onProgress(m_nDone, m_nTotal);
+
+  fill();
+}
+
+void
+RequestGroup::onDeadline(const boost::system::error_code& error, uint64_t round)
+{
+  if (error == boost::asio::error::operation_aborted || !m_isRunning || round != m_round)
+    return;
+
+  finish(false);
+}
+
+void
+RequestGroup::finishIfDone()
+{
+  if (m_isRunning && !m_isFilling && m_isClosed && m_queue.empty() && m_nPending == 0)
+    finish(true);
+}
+
+void
+RequestGroup::finish(bool isComplete)
+{
+  OnDone onDone = m_onDone;
+  cancel();
+
+  if (onDone)
+    onDone(isComplete);
+}
+
+} // namespace chronochat
@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#ifndef CHRONOCHAT_REQUEST_GROUP_HPP
+#define CHRONOCHAT_REQUEST_GROUP_HPP
+
+#include "common.hpp"
+#include <deque>
+
+namespace chronochat {
+
+/**
+ * @brief Runs rounds of asynchronous requests with a concurrency cap
+ *
+ * A round is started with start(), filled with add() and closed with close().  Queued
+ * requests are started in order, at most getLimit() at a time, and the round is done
+ * when it is closed and all of its requests have completed, or when its deadline passes.
+ *
+ * Each round has its own identity: starting a new round or cancelling the current one
+ * turns the completions of the old round into no-ops, so overlapping rounds are safe.
+ *
+ * A group is confined to the thread running @p ioService, which is also where requests
+ * complete, so it takes no locks.
+ */
+class RequestGroup : noncopyable
+{
+public:
+  /// @brief Handed to each request, to be called once when the request has finished
+  class Completion
+  {
+  public:
+    Completion(RequestGroup& group, uint64_t round);
+
+    /// @brief Report the request as finished; later calls are ignored
+    void
+    operator()() const;
+
+    /// @return whether the round of the request is still running
+    bool
+    isCurrent() const;
+
+  private:
+    RequestGroup* m_group;
+    uint64_t m_round;
+    shared_ptr<bool> m_isCalled;
+  };
+
+  typedef function<void(const Completion& done)> Request;
+  typedef function<void(size_t nDone, size_t nTotal)> OnProgress;
+  /// @param isComplete false if the deadline passed before all requests completed
+  typedef function<void(bool isComplete)> OnDone;
+
+  explicit
+  RequestGroup(boost::asio::io_service& ioService, size_t limit);
+
+  void
+  setLimit(size_t limit);
+
+  size_t
+  getLimit() const
+  {
+    return m_limit;
+  }
+
+  /**
+   * @brief Start a new round, cancelling the current one
+   *
+   * @param onProgress  called after each completed request
+   * @param onDone      called once when the round is done
+   * @param deadline    time after which the round is done even with requests in flight;
+   *                    a special value such as pos_infin means no deadline
+   */
+  void
+  start(const OnProgress& onProgress, const OnDone& onDone,
+        const boost::posix_time::time_duration& deadline = boost::posix_time::pos_infin);
+
+  /// @brief Queue @p request in the current round, ignored if no round is running
+  void
+  add(const Request& request);
+
+  /// @brief Announce that the current round gets no more requests
+  void
+  close();
+
+  /// @brief Stop the current round without calling its callbacks
+  void
+  cancel();
+
+  bool
+  isRunning() const
+  {
+    return m_isRunning;
+  }
+
+private:
+  void
+  fill();
+
+  void
+  onCompleted(uint64_t round);
+
+  void
+  onDeadline(const boost::system::error_code& error, uint64_t round);
+
+  void
+  finishIfDone();
+
+  void
+  finish(bool isComplete);
+
+private:
+  boost::asio::deadline_timer m_deadline;
+  size_t m_limit;
+
+  uint64_t m_round;
+  bool m_isRunning;
+  bool m_isClosed;
+  bool m_isFilling;
+  std::deque<Request> m_queue;
+  size_t m_nPending;
+  size_t m_nDone;
+  size_t m_nTotal;
+
+  OnProgress m_onProgress;
+  OnDone m_onDone;
+};
+
+} // namespace chronochat
+
+#endif // CHRONOCHAT_REQUEST_GROUP_HPP
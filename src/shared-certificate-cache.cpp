@@ -0,0 +1,294 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#include "shared-certificate-cache.hpp"
+#include "logging.h"
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <iterator>
+
+INIT_LOGGER("SharedCertificateCache");
+
+namespace chronochat {
+
+using std::string;
+using ndn::IdentityCertificate;
+
+namespace fs = boost::filesystem;
+
+const size_t SharedCertificateCache::DEFAULT_CAPACITY = 4096;
+
+SharedCertificateCache::SharedCertificateCache(const string& path, size_t capacity)
+  : m_path(path)
+  , m_capacity(capacity > 0 ? capacity : 1)
+  , m_needsRewrite(false)
+  , m_isStopping(false)
+  , m_nRecords(0)
+{
+  if (m_path.empty())
+    return;
+
+  load();
+  m_writer = std::thread(&SharedCertificateCache::runWriter, this);
+}
+
+SharedCertificateCache::~SharedCertificateCache()
+{
+  if (!m_writer.joinable())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_isStopping = true;
+  }
+  m_hasWrite.notify_all();
+  m_writer.join();
+}
+
+void
+SharedCertificateCache::insertCertificate(shared_ptr<const IdentityCertificate> certificate)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!insertInternal(certificate) || m_path.empty())
+      return;
+  }
+
+  queueWrite(certificate);
+}
+
+shared_ptr<const IdentityCertificate>
+SharedCertificateCache::getCertificate(const Name& certificateNameWithoutVersion)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Certificates::iterator it = m_certificates.find(certificateNameWithoutVersion);
+    if (it == m_certificates.end())
+      return shared_ptr<const IdentityCertificate>();
+
+    if (it->second->getNotAfter() > time::system_clock::now())
+      return it->second;
+
+    m_certificates.erase(it);
+  }
+
+  // drop the expired certificate from the file too
+  if (!m_path.empty())
+    queueWrite(shared_ptr<const IdentityCertificate>());
+  return shared_ptr<const IdentityCertificate>();
+}
+
+bool
+SharedCertificateCache::hasKskCertificateOf(const Name& identity)
+{
+  Name keyPrefix = Name(identity).append("KEY");
+  time::system_clock::TimePoint now = time::system_clock::now();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (Certificates::const_iterator it = m_certificates.lower_bound(keyPrefix);
+       it != m_certificates.end() && keyPrefix.isPrefixOf(it->first); it++) {
+    if (it->first.size() >= keyPrefix.size() + 2 &&
+        it->first.get(-2).toUri().compare(0, 4, "ksk-") == 0 &&
+        it->second->getNotAfter() > now)
+      return true;
+  }
+  return false;
+}
+
+void
+SharedCertificateCache::reset()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_certificates.clear();
+  }
+
+  if (!m_path.empty())
+    queueWrite(shared_ptr<const IdentityCertificate>());
+}
+
+size_t
+SharedCertificateCache::getSize()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_certificates.size();
+}
+
+bool
+SharedCertificateCache::insertInternal(const shared_ptr<const IdentityCertificate>& certificate)
+{
+  time::system_clock::TimePoint now = time::system_clock::now();
+  if (certificate->getNotAfter() <= now)
+    return false;
+
+  Name name = certificate->getName().getPrefix(-1);
+  Certificates::iterator it = m_certificates.find(name);
+  if (it != m_certificates.end()) {
+    if (it->second->wireEncode() == certificate->wireEncode())
+      return false;
+
+    it->second = certificate;
+    return true;
+  }
+
+  if (m_certificates.size() >= m_capacity) {
+    // drop the expired certificates, then if needed the one expiring first
+    Certificates::iterator first = m_certificates.end();
+    for (it = m_certificates.begin(); it != m_certificates.end();) {
+      if (it->second->getNotAfter() <= now)
+        m_certificates.erase(it++);
+      else {
+        if (first == m_certificates.end() ||
+            it->second->getNotAfter() < first->second->getNotAfter())
+          first = it;
+        ++it;
+      }
+    }
+
+    if (m_certificates.size() >= m_capacity)
+      m_certificates.erase(first);
+  }
+
+  m_certificates[name] = certificate;
+  return true;
+}
+
+void
+SharedCertificateCache::load()
+{
+  std::ifstream is(m_path.c_str(), std::ios::binary);
+  if (!is)
+    return;
+
+  string wire((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+  const uint8_t* buf = reinterpret_cast<const uint8_t*>(wire.data());
+
+  size_t offset = 0;
+  while (offset < wire.size()) {
+    Block block;
+    try {
+      block = Block(buf + offset, wire.size() - offset);
+    }
+    catch (tlv::Error&) {
+      // the last record was cut short
+      break;
+    }
+    offset += block.size();
+
+    try {
+      shared_ptr<IdentityCertificate> certificate = make_shared<IdentityCertificate>();
+      certificate->wireDecode(block);
+      insertInternal(certificate);
+    }
+    catch (tlv::Error&) {
+    }
+  }
+
+  // leave only the certificates that are still valid in the file, once the writer runs
+  m_needsRewrite = true;
+}
+
+void
+SharedCertificateCache::queueWrite(const shared_ptr<const IdentityCertificate>& certificate)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    if (static_cast<bool>(certificate))
+      m_pendingAppends.push_back(certificate);
+    else
+      m_needsRewrite = true;
+  }
+  m_hasWrite.notify_one();
+}
+
+void
+SharedCertificateCache::runWriter()
+{
+  while (true) {
+    std::vector<shared_ptr<const IdentityCertificate> > appends;
+    bool needsRewrite = false;
+    {
+      std::unique_lock<std::mutex> lock(m_writeMutex);
+      m_hasWrite.wait(lock, [this] {
+          return m_isStopping || m_needsRewrite || !m_pendingAppends.empty();
+        });
+      if (!m_needsRewrite && m_pendingAppends.empty())
+        return;
+
+      appends.swap(m_pendingAppends);
+      needsRewrite = m_needsRewrite;
+      m_needsRewrite = false;
+    }
+
+    // replaced and expired certificates stay in the file until it is rewritten
+    if (needsRewrite || m_nRecords + appends.size() > 2 * m_capacity)
+      save();
+    else {
+      for (size_t i = 0; i < appends.size(); i++) {
+        if (!append(*appends[i])) {
+          // a record cut short would make load() stop there, so rewrite the whole file
+          save();
+          break;
+        }
+      }
+    }
+  }
+}
+
+void
+SharedCertificateCache::save()
+{
+  Certificates certificates;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    certificates = m_certificates;
+  }
+
+  string tmpPath = m_path + ".tmp";
+  {
+    std::ofstream os(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+    for (Certificates::const_iterator it = certificates.begin();
+         it != certificates.end(); it++) {
+      const Block& wire = it->second->wireEncode();
+      os.write(reinterpret_cast<const char*>(wire.wire()), wire.size());
+    }
+    if (!os) {
+      _LOG_ERROR("Cannot write certificates to " << tmpPath);
+      return;
+    }
+  }
+
+  boost::system::error_code error;
+  fs::rename(tmpPath, m_path, error);
+  if (error) {
+    _LOG_ERROR("Cannot replace " << m_path << ": " << error.message());
+    return;
+  }
+  m_nRecords = certificates.size();
+}
+
+bool
+SharedCertificateCache::append(const IdentityCertificate& certificate)
+{
+  std::ofstream os(m_path.c_str(), std::ios::binary | std::ios::app);
+  const Block& wire = certificate.wireEncode();
+  os.write(reinterpret_cast<const char*>(wire.wire()), wire.size());
+  os.flush();
+  if (!os) {
+    _LOG_ERROR("Cannot append " << certificate.getName() << " to " << m_path);
+    return false;
+  }
+
+  m_nRecords++;
+  return true;
+}
+
+} // namespace chronochat
@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#ifndef CHRONOCHAT_SHARED_CERTIFICATE_CACHE_HPP
+#define CHRONOCHAT_SHARED_CERTIFICATE_CACHE_HPP
+
+#include "common.hpp"
+
+#include <ndn-cxx/security/certificate-cache.hpp>
+#include <ndn-cxx/security/identity-certificate.hpp>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace chronochat {
+
+/**
+ * @brief A thread-safe cache of verified certificates, shared by the validators of a policy
+ *
+ * A certificate is kept until its notAfter, or until it is evicted because the cache is full,
+ * in which case the certificate that expires first goes.  If the cache has a file, the
+ * certificates are appended to it as they are inserted and loaded back on construction, so
+ * they survive reconnects and restarts.  The file is written by a thread of the cache, so
+ * validators never wait for it.
+ */
+class SharedCertificateCache : public ndn::CertificateCache
+{
+public:
+  static const size_t DEFAULT_CAPACITY;
+
+  /// @param path  file the certificates are persisted in, nothing is persisted if empty
+  explicit
+  SharedCertificateCache(const std::string& path = "", size_t capacity = DEFAULT_CAPACITY);
+
+  /// @brief Write the pending certificates and stop the writer
+  virtual
+  ~SharedCertificateCache();
+
+  virtual void
+  insertCertificate(shared_ptr<const ndn::IdentityCertificate> certificate);
+
+  virtual shared_ptr<const ndn::IdentityCertificate>
+  getCertificate(const Name& certificateNameWithoutVersion);
+
+  /// @return true if a valid ksk certificate named <identity>/KEY/.../ID-CERT is cached
+  bool
+  hasKskCertificateOf(const Name& identity);
+
+  virtual void
+  reset();
+
+  virtual size_t
+  getSize();
+
+private:
+  /// @brief Insert without persisting, the caller holds m_mutex
+  bool
+  insertInternal(const shared_ptr<const ndn::IdentityCertificate>& certificate);
+
+  void
+  load();
+
+  /// @brief Queue @p certificate to be appended, or a rewrite if it is null
+  void
+  queueWrite(const shared_ptr<const ndn::IdentityCertificate>& certificate);
+
+  void
+  runWriter();
+
+  /// @brief Rewrite the file with the certificates in the cache only
+  void
+  save();
+
+  /// @return false if the certificate could not be written
+  bool
+  append(const ndn::IdentityCertificate& certificate);
+
+private:
+  typedef std::map<Name, shared_ptr<const ndn::IdentityCertificate> > Certificates;
+
+  std::mutex m_mutex;
+  std::string m_path;
+  size_t m_capacity;
+  Certificates m_certificates;
+
+  std::mutex m_writeMutex;
+  std::condition_variable m_hasWrite;
+  std::vector<shared_ptr<const ndn::IdentityCertificate> > m_pendingAppends;
+  bool m_needsRewrite;
+  bool m_isStopping;
+
+  // only touched by the writer: number of certificates in the file, including replaced and
+  // expired ones
+  size_t m_nRecords;
+
+  std::thread m_writer;
+};
+
+} // namespace chronochat
+
+#endif // CHRONOCHAT_SHARED_CERTIFICATE_CACHE_HPP
@@ -0,0 +1,176 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#include "signing-service.hpp"
+
+#include <algorithm>
+
+namespace chronochat {
+
+using std::string;
+using ndn::IdentityCertificate;
+
+const size_t SigningService::DEFAULT_QUEUE_LIMIT = 256;
+// bounds how long the first result of a batch waits for the others
+static const size_t MAX_BATCH_SIZE = 16;
+
+SigningService&
+SigningService::getDefault()
+{
+  // never destroyed, the loops it posts to may be gone by the time statics are
+  static SigningService* service = new SigningService(unique_ptr<ndn::KeyChain>(new ndn::KeyChain));
+  return *service;
+}
+
+SigningService::SigningService(unique_ptr<ndn::KeyChain> keyChain, size_t queueLimit)
+  : m_queueLimit(queueLimit > 0 ? queueLimit : 1)
+  , m_isStopping(false)
+  , m_keyChain(std::move(keyChain))
+{
+  m_thread = std::thread(&SigningService::run, this);
+}
+
+SigningService::~SigningService()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_isStopping = true;
+  }
+  m_hasTask.notify_all();
+  m_thread.join();
+}
+
+void
+SigningService::cancel(boost::asio::io_service& ioService)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(),
+                               [&ioService] (const Task& task) {
+                                 return task.ioService == &ioService;
+                               }),
+                m_queue.end());
+  // the results of the running batch are posted under the lock, after checking this
+  m_cancelled.insert(&ioService);
+}
+
+void
+SigningService::sign(const shared_ptr<Data>& data, const Name& identity,
+                     boost::asio::io_service& ioService,
+                     const OnSigned& onSigned, const OnFailure& onFailure)
+{
+  enqueue([this, data, identity] {
+      shared_ptr<IdentityCertificate> certificate = findCertificate(identity);
+      m_keyChain->sign(*data, certificate->getName());
+    },
+    &ioService, onSigned, onFailure);
+}
+
+void
+SigningService::getCertificate(const Name& identity,
+                               boost::asio::io_service& ioService,
+                               const OnCertificate& onCertificate, const OnFailure& onFailure)
+{
+  shared_ptr<shared_ptr<IdentityCertificate> > result =
+    make_shared<shared_ptr<IdentityCertificate> >();
+  enqueue([this, identity, result] { *result = findCertificate(identity); },
+          &ioService, [onCertificate, result] { onCertificate(*result); }, onFailure);
+}
+
+bool
+SigningService::enqueue(const Job& job, boost::asio::io_service* ioService,
+                        const OnSigned& onDone, const OnFailure& onFailure)
+{
+  Task task;
+  task.job = job;
+  task.ioService = ioService;
+  task.onDone = onDone;
+  task.onFailure = onFailure;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_queue.size() >= m_queueLimit) {
+      if (ioService != 0 && onFailure)
+        ioService->post(bind(onFailure, string("Signing queue is full")));
+      return false;
+    }
+    m_queue.push_back(task);
+  }
+  m_hasTask.notify_one();
+  return true;
+}
+
+shared_ptr<IdentityCertificate>
+SigningService::findCertificate(const Name& identity)
+{
+  std::map<Name, shared_ptr<IdentityCertificate> >::const_iterator it =
+    m_certificates.find(identity);
+  if (it != m_certificates.end())
+    return it->second;
+
+  Name certificateName = m_keyChain->getDefaultCertificateNameForIdentity(identity);
+  shared_ptr<IdentityCertificate> certificate = m_keyChain->getCertificate(certificateName);
+  if (!static_cast<bool>(certificate))
+    throw std::runtime_error("No certificate for " + identity.toUri());
+
+  m_certificates[identity] = certificate;
+  return certificate;
+}
+
+void
+SigningService::run()
+{
+  while (true) {
+    std::deque<Task> batch;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_hasTask.wait(lock, [this] { return m_isStopping || !m_queue.empty(); });
+      if (m_queue.empty())
+        return;
+
+      size_t batchSize = std::min(m_queue.size(), MAX_BATCH_SIZE);
+      batch.assign(m_queue.begin(), m_queue.begin() + batchSize);
+      m_queue.erase(m_queue.begin(), m_queue.begin() + batchSize);
+      m_cancelled.clear();
+    }
+
+    // callbacks of the batch, by the loop they are delivered to
+    std::map<boost::asio::io_service*, std::vector<Job> > results;
+    for (std::deque<Task>::const_iterator it = batch.begin(); it != batch.end(); it++) {
+      Job result;
+      try {
+        it->job();
+        result = it->onDone;
+      }
+      catch (std::exception& e) {
+        if (it->onFailure)
+          result = bind(it->onFailure, string(e.what()));
+      }
+
+      if (result && it->ioService != 0)
+        results[it->ioService].push_back(result);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (std::map<boost::asio::io_service*, std::vector<Job> >::iterator it = results.begin();
+         it != results.end(); it++) {
+      if (m_cancelled.count(it->first) > 0)
+        continue;
+
+      std::vector<Job> jobs;
+      jobs.swap(it->second);
+      it->first->post([jobs] {
+          for (std::vector<Job>::const_iterator job = jobs.begin(); job != jobs.end(); job++)
+            (*job)();
+        });
+    }
+  }
+}
+
+} // namespace chronochat
@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#ifndef CHRONOCHAT_SIGNING_SERVICE_HPP
+#define CHRONOCHAT_SIGNING_SERVICE_HPP
+
+#include "common.hpp"
+
+#include <ndn-cxx/security/key-chain.hpp>
+#include <boost/asio/io_service.hpp>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace chronochat {
+
+/**
+ * @brief Runs the KeyChain operations of the process on a dedicated thread
+ *
+ * All operations go through a single KeyChain owned by a worker thread, so the threads
+ * running network loops never wait for a private-key operation.  Operations are
+ * executed in the order they were queued, in batches, and the results of a batch are
+ * delivered with one handler per io_service.
+ *
+ * The default certificate of each identity is looked up once and kept until an
+ * operation queued with query() or call() runs, as it may change the defaults.
+ *
+ * The queue is bounded; an operation queued into a full queue fails at once, so that a
+ * network loop never waits for the worker.
+ *
+ * Results are posted to the io_service given with each operation.  The owner of that
+ * io_service, or of the objects its handlers use, must cancel() it before they are destroyed.
+ */
+class SigningService : noncopyable
+{
+public:
+  typedef function<void()> OnSigned;
+  typedef function<void(const shared_ptr<ndn::IdentityCertificate>&)> OnCertificate;
+  typedef function<void(const std::string&)> OnFailure;
+
+  static const size_t DEFAULT_QUEUE_LIMIT;
+
+  /// @brief The service of this process, using the default KeyChain
+  static SigningService&
+  getDefault();
+
+  explicit
+  SigningService(unique_ptr<ndn::KeyChain> keyChain, size_t queueLimit = DEFAULT_QUEUE_LIMIT);
+
+  /// @brief Execute all queued operations and stop the worker
+  ~SigningService();
+
+  /**
+   * @brief Drop the queued operations of @p ioService and the results not yet posted to it
+   *
+   * No handler is posted to @p ioService once this returns.  Operations already running
+   * are completed, but their results are discarded.
+   */
+  void
+  cancel(boost::asio::io_service& ioService);
+
+  /**
+   * @brief Sign @p data with the default certificate of @p identity
+   *
+   * @p data must not be touched until @p onSigned or @p onFailure, which are posted to
+   * @p ioService, is called.
+   */
+  void
+  sign(const shared_ptr<Data>& data, const Name& identity,
+       boost::asio::io_service& ioService,
+       const OnSigned& onSigned, const OnFailure& onFailure = OnFailure());
+
+  /// @brief Pass the default certificate of @p identity to @p onCertificate
+  void
+  getCertificate(const Name& identity,
+                 boost::asio::io_service& ioService,
+                 const OnCertificate& onCertificate, const OnFailure& onFailure = OnFailure());
+
+  /**
+   * @brief Run @p operation on the worker and pass its result to @p onResult
+   *
+   * @p onResult may be empty if only failures matter.
+   */
+  template<typename T>
+  void
+  query(const function<T(ndn::KeyChain&)>& operation,
+        boost::asio::io_service& ioService,
+        const function<void(const T&)>& onResult, const OnFailure& onFailure = OnFailure())
+  {
+    shared_ptr<T> result = make_shared<T>();
+    OnSigned onDone;
+    if (onResult)
+      onDone = [onResult, result] { onResult(*result); };
+
+    enqueue([this, operation, result] {
+        *result = operation(*m_keyChain);
+        m_certificates.clear();
+      },
+      &ioService, onDone, onFailure);
+  }
+
+  /**
+   * @brief Run @p operation on the worker and wait for its result
+   *
+   * Meant for startup and other code that is not running a network loop.
+   *
+   * @throw std::runtime_error the queue is full
+   * @throw std::exception what @p operation throws
+   */
+  template<typename T>
+  T
+  call(const function<T(ndn::KeyChain&)>& operation)
+  {
+    shared_ptr<std::packaged_task<T()> > task =
+      make_shared<std::packaged_task<T()> >([this, operation] {
+          T result = operation(*m_keyChain);
+          m_certificates.clear();
+          return result;
+        });
+    std::future<T> result = task->get_future();
+    if (!enqueue([task] { (*task)(); }, 0, OnSigned(), OnFailure()))
+      throw std::runtime_error("Signing queue is full");
+    return result.get();
+  }
+
+private:
+  typedef function<void()> Job;
+
+  struct Task
+  {
+    Job job;
+    boost::asio::io_service* ioService;
+    OnSigned onDone;
+    OnFailure onFailure;
+  };
+
+  /**
+   * @brief Queue @p job, or post @p onFailure to @p ioService if the queue is full
+   *
+   * @return false if the queue is full
+   */
+  bool
+  enqueue(const Job& job, boost::asio::io_service* ioService,
+          const OnSigned& onDone, const OnFailure& onFailure);
+
+  /// @brief The default certificate of @p identity, only called by the worker
+  shared_ptr<ndn::IdentityCertificate>
+  findCertificate(const Name& identity);
+
+  void
+  run();
+
+private:
+  size_t m_queueLimit;
+
+  std::mutex m_mutex;
+  std::condition_variable m_hasTask;
+  std::deque<Task> m_queue;
+  // loops cancelled while the current batch runs
+  std::set<boost::asio::io_service*> m_cancelled;
+  bool m_isStopping;
+
+  // only touched by the worker thread
+  unique_ptr<ndn::KeyChain> m_keyChain;
+  std::map<Name, shared_ptr<ndn::IdentityCertificate> > m_certificates;
+
+  std::thread m_thread;
+};
+
+} // namespace chronochat
+
+#endif // CHRONOCHAT_SIGNING_SERVICE_HPP
@@ -11,12 +11,15 @@
  */
 
 #include "tree-layout.hpp"
-#include <iostream>
+#include <algorithm>
+#include <boost/functional/hash.hpp>
 
 namespace chronochat {
 
+using std::string;
 using std::vector;
-using std::map;
+
+static const size_t UNCACHED_ORDER = static_cast<size_t>(-1);
 
 void
 OneLevelTreeLayout::setOneLevelLayout(vector<Coordinate>& childNodesCo)
@@ -36,32 +39,253 @@ OneLevelTreeLayout::setOneLevelLayout(vector<Coordinate>& childNodesCo)
 }
 
 void
-MultipleLevelTreeLayout::setMultipleLevelTreeLayout(TrustTreeNodeList& nodeList)
+MultipleLevelTreeLayout::setMultipleLevelTreeLayout(TrustGraph& graph)
 {
-  if (nodeList.empty())
+  if (graph.empty())
     return;
 
   double ld = getLevelDistance();
   double sd = getSiblingDistance();
 
-  map<int, double> layerSpan;
+  int minLevel = graph.getLevel(0);
+  int maxLevel = minLevel;
+  for (TrustGraph::NodeIndex node = 1; node < graph.size(); node++) {
+    minLevel = std::min(minLevel, graph.getLevel(node));
+    maxLevel = std::max(maxLevel, graph.getLevel(node));
+  }
+
+  vector<double> layerSpan(maxLevel - minLevel + 1, 0);
 
-  for (TrustTreeNodeList::iterator it = nodeList.begin(); it != nodeList.end(); it++) {
-    int layer = (*it)->level();
-    (*it)->y = layer * ld;
-    (*it)->x = layerSpan[layer];
-    layerSpan[layer] += sd;
+  for (TrustGraph::NodeIndex node = 0; node < graph.size(); node++) {
+    int layer = graph.getLevel(node);
+    double& span = layerSpan[layer - minLevel];
+    graph.setPosition(node, span, layer * ld);
+    span += sd;
   }
 
-  for (map<int, double>::iterator layerIt = layerSpan.begin();
+  for (vector<double>::iterator layerIt = layerSpan.begin();
        layerIt != layerSpan.end(); layerIt++) {
-    double shift = (layerIt->second - sd) / 2;
-    layerIt->second = shift;
+    double shift = (*layerIt - sd) / 2;
+    *layerIt = shift;
+  }
+
+  for (TrustGraph::NodeIndex node = 0; node < graph.size(); node++) {
+    graph.setPosition(node,
+                      graph.getX(node) - layerSpan[graph.getLevel(node) - minLevel],
+                      graph.getY(node));
+  }
+}
+
+LayeredTreeLayout::LayeredTreeLayout()
+  : m_minLevel(0)
+  , m_levelDistance(0)
+  , m_siblingDistance(0)
+  , m_nSweeps(4)
+  , m_nRelayoutLayers(0)
+{
+}
+
+void
+LayeredTreeLayout::reset()
+{
+  m_cache.clear();
+  m_layerSizes.clear();
+}
+
+void
+LayeredTreeLayout::setLayeredTreeLayout(TrustGraph& graph)
+{
+  m_nRelayoutLayers = 0;
+
+  if (graph.empty()) {
+    reset();
+    return;
+  }
+
+  double ld = getLevelDistance();
+  double sd = getSiblingDistance();
+
+  int minLevel = graph.getLevel(0);
+  int maxLevel = minLevel;
+  for (TrustGraph::NodeIndex node = 1; node < graph.size(); node++) {
+    minLevel = std::min(minLevel, graph.getLevel(node));
+    maxLevel = std::max(maxLevel, graph.getLevel(node));
+  }
+
+  if (minLevel != m_minLevel || getLevelDistance() != m_levelDistance ||
+      getSiblingDistance() != m_siblingDistance)
+    reset();
+  m_minLevel = minLevel;
+  m_levelDistance = getLevelDistance();
+  m_siblingDistance = getSiblingDistance();
+
+  size_t nLayers = maxLevel - minLevel + 1;
+
+  // A node's signature covers its own name and the names of its neighbours, so that a
+  // new or removed endorsement marks the layers of both ends as dirty.
+  vector<size_t> nameHash(graph.size());
+  for (TrustGraph::NodeIndex node = 0; node < graph.size(); node++)
+    nameHash[node] = boost::hash<string>()(graph.getName(node).toUri());
+
+  vector<size_t> signature(graph.size());
+  for (TrustGraph::NodeIndex node = 0; node < graph.size(); node++) {
+    size_t introducerSum = 0;
+    size_t introduceeSum = 0;
+    TrustGraph::Neighbors introducers = graph.getIntroducers(node);
+    for (TrustGraph::Neighbors::const_iterator it = introducers.begin();
+         it != introducers.end(); it++)
+      introducerSum += nameHash[*it];
+    TrustGraph::Neighbors introducees = graph.getIntroducees(node);
+    for (TrustGraph::Neighbors::const_iterator it = introducees.begin();
+         it != introducees.end(); it++)
+      introduceeSum += nameHash[*it];
+
+    size_t seed = nameHash[node];
+    boost::hash_combine(seed, introducerSum);
+    boost::hash_combine(seed, introduceeSum);
+    signature[node] = seed;
+  }
+
+  // Distribute nodes over layers and find out which layers differ from the cache
+  vector<Layer> layers(nLayers);
+  vector<bool> isDirty(nLayers, false);
+  vector<size_t> nCached(nLayers, 0);
+  vector<const CachedNode*> cached(graph.size(), 0);
+
+  for (TrustGraph::NodeIndex node = 0; node < graph.size(); node++) {
+    size_t layer = graph.getLevel(node) - minLevel;
+    layers[layer].push_back(node);
+
+    LayoutCache::const_iterator it = m_cache.find(graph.getName(node));
+    if (it == m_cache.end() || it->second.level != graph.getLevel(node) ||
+        it->second.signature != signature[node])
+      isDirty[layer] = true;
+
+    if (it != m_cache.end() && it->second.level == graph.getLevel(node)) {
+      cached[node] = &it->second;
+      nCached[layer]++;
+    }
+  }
+
+  vector<double> position(graph.size());
+  for (size_t layer = 0; layer < nLayers; layer++) {
+    // a node that left the layer makes the cached count differ
+    if (layer >= m_layerSizes.size() || m_layerSizes[layer] != nCached[layer])
+      isDirty[layer] = true;
+
+    // start from the cached order, new nodes go to the end
+    std::stable_sort(layers[layer].begin(), layers[layer].end(),
+                     [&cached] (TrustGraph::NodeIndex a, TrustGraph::NodeIndex b) {
+                       size_t orderA = cached[a] ? cached[a]->order : UNCACHED_ORDER;
+                       size_t orderB = cached[b] ? cached[b]->order : UNCACHED_ORDER;
+                       return orderA < orderB;
+                     });
+
+    for (size_t i = 0; i < layers[layer].size(); i++)
+      position[layers[layer][i]] = (i + 0.5) / layers[layer].size();
   }
 
-  for (TrustTreeNodeList::iterator it = nodeList.begin(); it != nodeList.end(); it++) {
-    (*it)->x -= layerSpan[(*it)->level()];
+  // Barycentric crossing reduction, restricted to dirty layers and those below (downward
+  // sweep) or above (upward sweep) a layer that has moved.
+  vector<bool> isTouched(isDirty);
+  for (size_t sweep = 0; sweep < m_nSweeps; sweep++) {
+    bool isDownward = (sweep % 2 == 0);
+    bool hasNeighborMoved = false;
+
+    for (size_t i = 0; i < nLayers; i++) {
+      size_t layer = isDownward ? i : nLayers - 1 - i;
+
+      if (isDirty[layer] || hasNeighborMoved) {
+        if (reorderLayer(graph, layers[layer], position, isDownward))
+          isTouched[layer] = true;
+      }
+
+      if (isTouched[layer])
+        hasNeighborMoved = true;
+    }
+  }
+
+  // Coordinates: untouched layers keep their cached positions
+  for (size_t layer = 0; layer < nLayers; layer++) {
+    const Layer& nodes = layers[layer];
+    double y = (layer + minLevel) * ld;
+    double shift = (nodes.size() - 1) * sd / 2;
+
+    if (isTouched[layer])
+      m_nRelayoutLayers++;
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+      if (isTouched[layer])
+        graph.setPosition(nodes[i], i * sd - shift, y);
+      else
+        graph.setPosition(nodes[i], cached[nodes[i]]->x, y);
+    }
   }
+
+  if (m_nRelayoutLayers == 0)
+    return;
+
+  // Refresh the cache
+  m_cache.clear();
+  m_layerSizes.assign(nLayers, 0);
+  for (size_t layer = 0; layer < nLayers; layer++) {
+    const Layer& nodes = layers[layer];
+    m_layerSizes[layer] = nodes.size();
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+      CachedNode& entry = m_cache[graph.getName(nodes[i])];
+      entry.level = graph.getLevel(nodes[i]);
+      entry.order = i;
+      entry.signature = signature[nodes[i]];
+      entry.x = graph.getX(nodes[i]);
+    }
+  }
+}
+
+bool
+LayeredTreeLayout::reorderLayer(const TrustGraph& graph, Layer& layer,
+                                vector<double>& position, bool isDownward)
+{
+  vector<std::pair<double, size_t> > keys;
+  keys.reserve(layer.size());
+
+  for (size_t i = 0; i < layer.size(); i++) {
+    TrustGraph::NodeIndex node = layer[i];
+    TrustGraph::Neighbors neighbors = isDownward ? graph.getIntroducers(node) :
+                                                   graph.getIntroducees(node);
+    double sum = 0;
+    size_t count = 0;
+    for (TrustGraph::Neighbors::const_iterator it = neighbors.begin();
+         it != neighbors.end(); it++) {
+      // only edges that point across layers in the direction of the sweep
+      if (isDownward ? graph.getLevel(*it) < graph.getLevel(node) :
+                       graph.getLevel(*it) > graph.getLevel(node)) {
+        sum += position[*it];
+        count++;
+      }
+    }
+
+    // nodes without neighbours on that side keep their place
+    keys.push_back(std::make_pair(count > 0 ? sum / count : position[node], i));
+  }
+
+  std::sort(keys.begin(), keys.end());
+
+  bool isChanged = false;
+  Layer reordered(layer.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    reordered[i] = layer[keys[i].second];
+    if (keys[i].second != i)
+      isChanged = true;
+  }
+
+  if (!isChanged)
+    return false;
+
+  layer.swap(reordered);
+  for (size_t i = 0; i < layer.size(); i++)
+    position[layer[i]] = (i + 0.5) / layer.size();
+  return true;
 }
 
 } // namespace chronochat
@@ -13,7 +13,7 @@
 #ifndef CHRONOCHAT_TREE_LAYOUT_HPP
 #define CHRONOCHAT_TREE_LAYOUT_HPP
 
-#include "trust-tree-node.hpp"
+#include "trust-graph.hpp"
 
 namespace chronochat {
 
@@ -97,7 +97,73 @@ public:
   {
   }
 
-  virtual void setMultipleLevelTreeLayout(TrustTreeNodeList& nodeList);
+  virtual void setMultipleLevelTreeLayout(TrustGraph& graph);
+};
+
+/**
+ * @brief Sugiyama-style layered layout of a TrustGraph
+ *
+ * Layers are the node levels.  Nodes within a layer are ordered by alternating
+ * downward and upward barycentric sweeps to reduce edge crossings.  The order and
+ * position of every node is cached by name, so a later call only reorders the layers
+ * whose membership or adjacency changed, plus the layers whose neighbours moved.
+ *
+ * The graph must be finalized and have its levels computed.
+ */
+class LayeredTreeLayout : public TreeLayout
+{
+public:
+  LayeredTreeLayout();
+
+  virtual ~LayeredTreeLayout()
+  {
+  }
+
+  void
+  setLayeredTreeLayout(TrustGraph& graph);
+
+  /// @brief Drop the cached layout, the next call lays out every layer
+  void
+  reset();
+
+  void
+  setSweepCount(size_t nSweeps)
+  {
+    m_nSweeps = nSweeps;
+  }
+
+  /// @return number of layers reordered by the last setLayeredTreeLayout()
+  size_t
+  getRelayoutLayerCount() const
+  {
+    return m_nRelayoutLayers;
+  }
+
+private:
+  typedef std::vector<TrustGraph::NodeIndex> Layer;
+
+  bool
+  reorderLayer(const TrustGraph& graph, Layer& layer,
+               std::vector<double>& position, bool isDownward);
+
+private:
+  struct CachedNode
+  {
+    int level;
+    size_t order;
+    size_t signature;
+    double x;
+  };
+
+  typedef std::map<Name, CachedNode> LayoutCache;
+
+  LayoutCache m_cache;
+  std::vector<size_t> m_layerSizes;
+  int m_minLevel;
+  int m_levelDistance;
+  int m_siblingDistance;
+  size_t m_nSweeps;
+  size_t m_nRelayoutLayers;
 };
 
 } // namespace chronochat
@@ -0,0 +1,197 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#include "trust-graph.hpp"
+
+#include <algorithm>
+
+namespace chronochat {
+
+using std::vector;
+
+const TrustGraph::NodeIndex TrustGraph::INVALID_NODE = static_cast<NodeIndex>(-1);
+
+TrustGraph::TrustGraph()
+  : m_isFinalized(false)
+{
+}
+
+void
+TrustGraph::reserve(size_t nNodes, size_t nEdges)
+{
+  m_names.reserve(nNodes);
+  m_levels.reserve(nNodes);
+  m_visited.reserve(nNodes);
+  m_x.reserve(nNodes);
+  m_y.reserve(nNodes);
+  m_edges.reserve(nEdges);
+}
+
+void
+TrustGraph::clear()
+{
+  m_nameIndex.clear();
+  m_names.clear();
+  m_levels.clear();
+  m_visited.clear();
+  m_x.clear();
+  m_y.clear();
+  m_edges.clear();
+  m_introduceeOffsets.clear();
+  m_introducees.clear();
+  m_introducerOffsets.clear();
+  m_introducers.clear();
+  m_isFinalized = false;
+}
+
+TrustGraph::NodeIndex
+TrustGraph::addNode(const Name& name)
+{
+  std::pair<NameIndex::iterator, bool> result =
+    m_nameIndex.insert(std::make_pair(name, m_names.size()));
+  if (!result.second)
+    return result.first->second;
+
+  m_names.push_back(name);
+  m_levels.push_back(-1);
+  m_visited.push_back(0);
+  m_x.push_back(0);
+  m_y.push_back(0);
+  m_isFinalized = false;
+
+  return result.first->second;
+}
+
+TrustGraph::NodeIndex
+TrustGraph::findNode(const Name& name) const
+{
+  NameIndex::const_iterator it = m_nameIndex.find(name);
+  if (it == m_nameIndex.end())
+    return INVALID_NODE;
+  return it->second;
+}
+
+void
+TrustGraph::addEdge(NodeIndex introducer, NodeIndex introducee)
+{
+  if (introducer >= size() || introducee >= size())
+    throw Error("Edge refers to an unknown node");
+
+  m_edges.push_back(Edge(introducer, introducee));
+  m_isFinalized = false;
+}
+
+void
+TrustGraph::buildCsr(size_t nNodes, const vector<Edge>& edges, bool isReversed,
+                     vector<size_t>& offsets, vector<NodeIndex>& indices)
+{
+  // counting sort of the edges by their source node
+  offsets.assign(nNodes + 1, 0);
+  for (vector<Edge>::const_iterator it = edges.begin(); it != edges.end(); it++)
+    offsets[(isReversed ? it->second : it->first) + 1]++;
+
+  for (size_t i = 0; i < nNodes; i++)
+    offsets[i + 1] += offsets[i];
+
+  indices.resize(edges.size());
+  vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+  for (vector<Edge>::const_iterator it = edges.begin(); it != edges.end(); it++) {
+    if (isReversed)
+      indices[cursor[it->second]++] = it->first;
+    else
+      indices[cursor[it->first]++] = it->second;
+  }
+}
+
+void
+TrustGraph::finalize()
+{
+  buildCsr(size(), m_edges, false, m_introduceeOffsets, m_introducees);
+  buildCsr(size(), m_edges, true, m_introducerOffsets, m_introducers);
+  m_isFinalized = true;
+}
+
+TrustGraph::Neighbors
+TrustGraph::getIntroducees(NodeIndex node) const
+{
+  if (!m_isFinalized)
+    throw Error("TrustGraph is not finalized");
+
+  const NodeIndex* base = m_introducees.empty() ? 0 : &m_introducees[0];
+  return Neighbors(base + m_introduceeOffsets[node], base + m_introduceeOffsets[node + 1]);
+}
+
+TrustGraph::Neighbors
+TrustGraph::getIntroducers(NodeIndex node) const
+{
+  if (!m_isFinalized)
+    throw Error("TrustGraph is not finalized");
+
+  const NodeIndex* base = m_introducers.empty() ? 0 : &m_introducers[0];
+  return Neighbors(base + m_introducerOffsets[node], base + m_introducerOffsets[node + 1]);
+}
+
+void
+TrustGraph::resetVisited()
+{
+  std::fill(m_visited.begin(), m_visited.end(), 0);
+}
+
+void
+TrustGraph::computeLevels()
+{
+  if (!m_isFinalized)
+    throw Error("TrustGraph is not finalized");
+
+  resetVisited();
+  std::fill(m_levels.begin(), m_levels.end(), -1);
+
+  vector<NodeIndex> queue;
+  queue.reserve(size());
+
+  // all roots are seeded at once, so every node gets its distance to the nearest root
+  for (NodeIndex node = 0; node < size(); node++) {
+    if (getIntroducers(node).empty()) {
+      setVisited(node);
+      m_levels[node] = 0;
+      queue.push_back(node);
+    }
+  }
+  size_t head = 0;
+  breadthFirstSearch(queue, head);
+
+  // whatever is left unreached sits on an introducer cycle
+  for (NodeIndex node = 0; node < size(); node++) {
+    if (isVisited(node))
+      continue;
+    setVisited(node);
+    m_levels[node] = 0;
+    queue.push_back(node);
+    breadthFirstSearch(queue, head);
+  }
+}
+
+void
+TrustGraph::breadthFirstSearch(vector<NodeIndex>& queue, size_t& head)
+{
+  for (; head < queue.size(); head++) {
+    NodeIndex node = queue[head];
+    Neighbors introducees = getIntroducees(node);
+    for (Neighbors::const_iterator it = introducees.begin(); it != introducees.end(); it++) {
+      if (isVisited(*it))
+        continue;
+      setVisited(*it);
+      m_levels[*it] = m_levels[node] + 1;
+      queue.push_back(*it);
+    }
+  }
+}
+
+} // namespace chronochat
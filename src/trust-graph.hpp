@@ -0,0 +1,235 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#ifndef CHRONOCHAT_TRUST_GRAPH_HPP
+#define CHRONOCHAT_TRUST_GRAPH_HPP
+
+#include "common.hpp"
+
+namespace chronochat {
+
+/**
+ * @brief Compact graph of introducer -> introducee relations.
+ *
+ * Nodes live in contiguous parallel arrays (name, level, visited flag, position) and are
+ * addressed by index.  Edges are collected with addEdge() and compacted into CSR
+ * adjacency arrays by finalize(), one array for introducees and one for introducers.
+ * The graph holds no pointers between nodes, so it cannot leak through cycles.
+ */
+class TrustGraph
+{
+public:
+  class Error : public std::runtime_error
+  {
+  public:
+    explicit
+    Error(const std::string& what)
+      : std::runtime_error(what)
+    {
+    }
+  };
+
+  typedef size_t NodeIndex;
+
+  static const NodeIndex INVALID_NODE;
+
+  /// @brief A read-only view of one CSR adjacency row
+  class Neighbors
+  {
+  public:
+    typedef const NodeIndex* const_iterator;
+
+    Neighbors(const_iterator begin, const_iterator end)
+      : m_begin(begin)
+      , m_end(end)
+    {
+    }
+
+    const_iterator
+    begin() const
+    {
+      return m_begin;
+    }
+
+    const_iterator
+    end() const
+    {
+      return m_end;
+    }
+
+    size_t
+    size() const
+    {
+      return m_end - m_begin;
+    }
+
+    bool
+    empty() const
+    {
+      return m_begin == m_end;
+    }
+
+  private:
+    const_iterator m_begin;
+    const_iterator m_end;
+  };
+
+public:
+  TrustGraph();
+
+  void
+  reserve(size_t nNodes, size_t nEdges);
+
+  void
+  clear();
+
+  /**
+   * @brief Add a node named @p name
+   *
+   * @return index of the new node, or of the existing node with the same name
+   */
+  NodeIndex
+  addNode(const Name& name);
+
+  /// @return index of the node named @p name, or INVALID_NODE
+  NodeIndex
+  findNode(const Name& name) const;
+
+  /**
+   * @brief Record that @p introducer introduces @p introducee
+   *
+   * The edge becomes visible through getIntroducees() and getIntroducers() after the
+   * next finalize().
+   */
+  void
+  addEdge(NodeIndex introducer, NodeIndex introducee);
+
+  /// @brief Build the CSR adjacency arrays from the recorded edges
+  void
+  finalize();
+
+  /**
+   * @brief Assign levels by breadth-first search from the root nodes
+   *
+   * Roots are nodes without introducers.  Nodes that are not reachable from any root
+   * (e.g., those on a cycle) start a new search at level 0.  The graph must be finalized.
+   */
+  void
+  computeLevels();
+
+  size_t
+  size() const
+  {
+    return m_names.size();
+  }
+
+  bool
+  empty() const
+  {
+    return m_names.empty();
+  }
+
+  size_t
+  getEdgeCount() const
+  {
+    return m_edges.size();
+  }
+
+  const Name&
+  getName(NodeIndex node) const
+  {
+    return m_names[node];
+  }
+
+  Neighbors
+  getIntroducees(NodeIndex node) const;
+
+  Neighbors
+  getIntroducers(NodeIndex node) const;
+
+  int
+  getLevel(NodeIndex node) const
+  {
+    return m_levels[node];
+  }
+
+  void
+  setLevel(NodeIndex node, int level)
+  {
+    m_levels[node] = level;
+  }
+
+  bool
+  isVisited(NodeIndex node) const
+  {
+    return m_visited[node] != 0;
+  }
+
+  void
+  setVisited(NodeIndex node)
+  {
+    m_visited[node] = 1;
+  }
+
+  void
+  resetVisited();
+
+  double
+  getX(NodeIndex node) const
+  {
+    return m_x[node];
+  }
+
+  double
+  getY(NodeIndex node) const
+  {
+    return m_y[node];
+  }
+
+  void
+  setPosition(NodeIndex node, double x, double y)
+  {
+    m_x[node] = x;
+    m_y[node] = y;
+  }
+
+private:
+  typedef std::map<Name, NodeIndex> NameIndex;
+  typedef std::pair<NodeIndex, NodeIndex> Edge;
+
+  static void
+  buildCsr(size_t nNodes, const std::vector<Edge>& edges, bool isReversed,
+           std::vector<size_t>& offsets, std::vector<NodeIndex>& indices);
+
+  void
+  breadthFirstSearch(std::vector<NodeIndex>& queue, size_t& head);
+
+private:
+  NameIndex m_nameIndex;
+
+  // node arena
+  std::vector<Name> m_names;
+  std::vector<int> m_levels;
+  std::vector<uint8_t> m_visited;
+  std::vector<double> m_x;
+  std::vector<double> m_y;
+
+  // edges, as recorded and in CSR form
+  std::vector<Edge> m_edges;
+  bool m_isFinalized;
+  std::vector<size_t> m_introduceeOffsets;
+  std::vector<NodeIndex> m_introducees;
+  std::vector<size_t> m_introducerOffsets;
+  std::vector<NodeIndex> m_introducers;
+};
+
+} // namespace chronochat
+
+#endif // CHRONOCHAT_TRUST_GRAPH_HPP
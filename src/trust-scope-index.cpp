@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#include "trust-scope-index.hpp"
+
+namespace chronochat {
+
+void
+TrustScopeIndex::insert(const Contact& contact)
+{
+  if (!contact.isIntroducer())
+    return;
+
+  for (Contact::const_iterator it = contact.trustScopeBegin(); it != contact.trustScopeEnd(); it++)
+    insert(contact.getNameSpace(), it->first);
+}
+
+void
+TrustScopeIndex::insert(const Name& introducer, const Name& scope)
+{
+  if (!m_scopes[introducer].insert(scope).second)
+    return;
+
+  Node* node = &m_root;
+  for (Name::const_iterator it = scope.begin(); it != scope.end(); it++) {
+    shared_ptr<Node>& child = node->children[*it];
+    if (!static_cast<bool>(child))
+      child = make_shared<Node>();
+    node = child.get();
+  }
+  node->introducers.insert(introducer);
+}
+
+void
+TrustScopeIndex::erase(const Name& introducer)
+{
+  std::map<Name, std::set<Name> >::iterator scopes = m_scopes.find(introducer);
+  if (scopes == m_scopes.end())
+    return;
+
+  for (std::set<Name>::const_iterator scope = scopes->second.begin();
+       scope != scopes->second.end(); scope++) {
+    std::vector<Node*> path(1, &m_root);
+    for (Name::const_iterator it = scope->begin(); it != scope->end(); it++)
+      path.push_back(path.back()->children[*it].get());
+
+    path.back()->introducers.erase(introducer);
+
+    // prune the nodes that no longer lead to any scope
+    for (size_t i = path.size() - 1; i > 0; i--) {
+      if (!path[i]->introducers.empty() || !path[i]->children.empty())
+        break;
+      path[i - 1]->children.erase(scope->get(i - 1));
+    }
+  }
+
+  m_scopes.erase(scopes);
+}
+
+void
+TrustScopeIndex::clear()
+{
+  m_root.children.clear();
+  m_root.introducers.clear();
+  m_scopes.clear();
+}
+
+TrustScopeIndex::Introducers
+TrustScopeIndex::findIntroducers(const Name& name) const
+{
+  Introducers introducers(m_root.introducers);
+
+  const Node* node = &m_root;
+  for (Name::const_iterator it = name.begin(); it != name.end(); it++) {
+    std::map<name::Component, shared_ptr<Node> >::const_iterator child = node->children.find(*it);
+    if (child == node->children.end())
+      break;
+
+    node = child->second.get();
+    introducers.insert(node->introducers.begin(), node->introducers.end());
+  }
+
+  return introducers;
+}
+
+bool
+TrustScopeIndex::canBeTrustedFor(const Name& introducer, const Name& name) const
+{
+  const Node* node = &m_root;
+  if (node->introducers.count(introducer) > 0)
+    return true;
+
+  for (Name::const_iterator it = name.begin(); it != name.end(); it++) {
+    std::map<name::Component, shared_ptr<Node> >::const_iterator child = node->children.find(*it);
+    if (child == node->children.end())
+      return false;
+
+    node = child->second.get();
+    if (node->introducers.count(introducer) > 0)
+      return true;
+  }
+
+  return false;
+}
+
+size_t
+TrustScopeIndex::size() const
+{
+  size_t nScopes = 0;
+  for (std::map<Name, std::set<Name> >::const_iterator it = m_scopes.begin();
+       it != m_scopes.end(); it++)
+    nScopes += it->second.size();
+  return nScopes;
+}
+
+} // namespace chronochat
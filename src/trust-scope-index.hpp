@@ -0,0 +1,69 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#ifndef CHRONOCHAT_TRUST_SCOPE_INDEX_HPP
+#define CHRONOCHAT_TRUST_SCOPE_INDEX_HPP
+
+#include "contact.hpp"
+#include <set>
+
+namespace chronochat {
+
+/**
+ * @brief Name-component trie over the trust scopes of all introducers.
+ *
+ * A trust scope is a name prefix, as in Contact::canBeTrustedFor.  Each trie node keeps
+ * the introducers whose scope ends there, so the introducers that may vouch for a name
+ * are collected in a single walk along the name, whatever the number of scopes.
+ */
+class TrustScopeIndex
+{
+public:
+  typedef std::set<Name> Introducers;
+
+  /// @brief Index the trust scopes of @p contact if it is an introducer
+  void
+  insert(const Contact& contact);
+
+  void
+  insert(const Name& introducer, const Name& scope);
+
+  /// @brief Remove all trust scopes of @p introducer
+  void
+  erase(const Name& introducer);
+
+  void
+  clear();
+
+  /// @return introducers with a trust scope that is a prefix of @p name
+  Introducers
+  findIntroducers(const Name& name) const;
+
+  bool
+  canBeTrustedFor(const Name& introducer, const Name& name) const;
+
+  /// @return number of indexed (introducer, scope) pairs
+  size_t
+  size() const;
+
+private:
+  struct Node
+  {
+    std::map<name::Component, shared_ptr<Node> > children;
+    Introducers introducers;
+  };
+
+  Node m_root;
+  std::map<Name, std::set<Name> > m_scopes;
+};
+
+} // namespace chronochat
+
+#endif // CHRONOCHAT_TRUST_SCOPE_INDEX_HPP
@@ -24,40 +24,37 @@ static const double Pi = 3.14159265358979323846264338327950288419717;
 TrustTreeScene::TrustTreeScene(QWidget* parent)
   : QGraphicsScene(parent)
 {
+  m_layout.setSiblingDistance(100);
+  m_layout.setLevelDistance(100);
 }
 
 void
-TrustTreeScene::plotTrustTree(TrustTreeNodeList& nodeList)
+TrustTreeScene::plotTrustTree(TrustGraph& graph)
 {
   clear();
 
   int nodeSize = 40;
-  int siblingDistance = 100;
-  int levelDistance = 100;
 
-  shared_ptr<MultipleLevelTreeLayout> layout(new MultipleLevelTreeLayout());
-  layout->setSiblingDistance(siblingDistance);
-  layout->setLevelDistance(levelDistance);
-  layout->setMultipleLevelTreeLayout(nodeList);
+  m_layout.setLayeredTreeLayout(graph);
 
-  plotEdge(nodeList, nodeSize);
-  plotNode(nodeList, nodeSize);
+  plotEdge(graph, nodeSize);
+  plotNode(graph, nodeSize);
 }
 
 void
-TrustTreeScene::plotEdge(const TrustTreeNodeList& nodeList, int nodeSize)
+TrustTreeScene::plotEdge(const TrustGraph& graph, int nodeSize)
 {
-  for (TrustTreeNodeList::const_iterator it = nodeList.begin(); it != nodeList.end(); it++) {
-    TrustTreeNodeList& introducees = (*it)->getIntroducees();
-    for (TrustTreeNodeList::iterator eeIt = introducees.begin();
+  for (TrustGraph::NodeIndex node = 0; node < graph.size(); node++) {
+    TrustGraph::Neighbors introducees = graph.getIntroducees(node);
+    for (TrustGraph::Neighbors::const_iterator eeIt = introducees.begin();
          eeIt != introducees.end(); eeIt++) {
-      if ((*it)->level() >= (*eeIt)->level())
+      if (graph.getLevel(node) >= graph.getLevel(*eeIt))
         continue;
 
-      double x1 = (*it)->x;
-      double y1 = (*it)->y;
-      double x2 = (*eeIt)->x;
-      double y2 = (*eeIt)->y;
+      double x1 = graph.getX(node);
+      double y1 = graph.getY(node);
+      double x2 = graph.getX(*eeIt);
+      double y2 = graph.getY(*eeIt);
 
       QPointF src(x1 + nodeSize/2, y1 + nodeSize/2);
       QPointF dest(x2 + nodeSize/2, y2 + nodeSize/2);
@@ -81,14 +78,14 @@ TrustTreeScene::plotEdge(const TrustTreeNodeList& nodeList, int nodeSize)
 }
 
 void
-TrustTreeScene::plotNode(const TrustTreeNodeList& nodeList, int nodeSize)
+TrustTreeScene::plotNode(const TrustGraph& graph, int nodeSize)
 {
   int rim = 3;
 
   // plot nodes
-  for (TrustTreeNodeList::const_iterator it = nodeList.begin(); it != nodeList.end(); it++) {
-    double x = (*it)->x;
-    double y = (*it)->y;
+  for (TrustGraph::NodeIndex node = 0; node < graph.size(); node++) {
+    double x = graph.getX(node);
+    double y = graph.getY(node);
     QRectF boundingRect(x, y, nodeSize, nodeSize);
     QRectF innerBoundingRect(x + rim, y + rim, nodeSize - rim * 2, nodeSize - rim * 2);
     addRect(boundingRect, QPen(Qt::black), QBrush(Qt::darkBlue));
@@ -96,7 +93,7 @@ TrustTreeScene::plotNode(const TrustTreeNodeList& nodeList, int nodeSize)
 
     QRectF textRect(x - nodeSize / 2, y + nodeSize, 2 * nodeSize, 30);
     addRect(textRect, QPen(Qt::darkCyan), QBrush(Qt::darkCyan));
-    QGraphicsTextItem *nickItem = addText(QString::fromStdString((*it)->name().toUri()));
+    QGraphicsTextItem *nickItem = addText(QString::fromStdString(graph.getName(node).toUri()));
     nickItem->setDefaultTextColor(Qt::white);
     nickItem->setFont(QFont("Cursive", 8, QFont::Bold));
     nickItem->setPos(x - nodeSize / 2 + 10, y + nodeSize + 5);
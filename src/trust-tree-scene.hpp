@@ -16,7 +16,7 @@
 #include <QMap>
 
 #ifndef Q_MOC_RUN
-#include "trust-tree-node.hpp"
+#include "trust-graph.hpp"
 #include "tree-layout.hpp"
 #endif
 
@@ -32,14 +32,18 @@ public:
   TrustTreeScene(QWidget* parent = 0);
 
   void
-  plotTrustTree(chronochat::TrustTreeNodeList& nodeList);
+  plotTrustTree(chronochat::TrustGraph& graph);
 
 private:
   void
-  plotEdge(const chronochat::TrustTreeNodeList& nodeList, int nodeSize);
+  plotEdge(const chronochat::TrustGraph& graph, int nodeSize);
 
   void
-  plotNode(const chronochat::TrustTreeNodeList& nodeList, int nodeSize);
+  plotNode(const chronochat::TrustGraph& graph, int nodeSize);
+
+private:
+  // kept across plots so that only changed layers are laid out again
+  LayeredTreeLayout m_layout;
 };
 
 } // namespace chronochat
@@ -0,0 +1,185 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#include "validation-policy.hpp"
+
+#include <QFile>
+#include <boost/filesystem.hpp>
+#include <ndn-cxx/security/sec-rule-relative.hpp>
+#include <ndn-cxx/util/io.hpp>
+#include <mutex>
+#include <sstream>
+
+namespace chronochat {
+
+using std::string;
+using ndn::IdentityCertificate;
+using ndn::SecRuleRelative;
+
+/**
+ * @brief A rule shared by validators running on different threads
+ *
+ * Matching a rule keeps the match in its regexes, so its uses are serialized.
+ */
+class SharedRule : public SecRuleRelative
+{
+public:
+  SharedRule(const string& dataRegex, const string& signerRegex, const string& op,
+             const string& dataExpand, const string& signerExpand)
+    : SecRuleRelative(dataRegex, signerRegex, op, dataExpand, signerExpand, true)
+  {
+  }
+
+  virtual bool
+  matchDataName(const Data& data)
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    return SecRuleRelative::matchDataName(data);
+  }
+
+  virtual bool
+  matchSignerName(const Data& data)
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    return SecRuleRelative::matchSignerName(data);
+  }
+
+  virtual bool
+  satisfy(const Data& data)
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    return SecRuleRelative::satisfy(data);
+  }
+
+  virtual bool
+  satisfy(const Name& dataName, const Name& signerName)
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    return SecRuleRelative::satisfy(dataName, signerName);
+  }
+
+private:
+  // recursive, as a check may call the other checks of the rule
+  std::recursive_mutex m_mutex;
+};
+
+static shared_ptr<SecRuleRelative>
+makeRule(const string& dataRegex, const string& signerRegex, const string& op,
+         const string& dataExpand, const string& signerExpand)
+{
+  return make_shared<SharedRule>(dataRegex, signerRegex, op, dataExpand, signerExpand);
+}
+
+/// @brief Load the anchor compiled into the resources of the application
+static shared_ptr<IdentityCertificate>
+loadTrustAnchor()
+{
+  QFile anchorFile(":/security/anchor.cert");
+  if (!anchorFile.open(QIODevice::ReadOnly))
+    return shared_ptr<IdentityCertificate>();
+
+  QByteArray content = anchorFile.readAll();
+  std::istringstream is(string(content.constData(), content.size()));
+  return ndn::io::load<IdentityCertificate>(is);
+}
+
+/// @brief A cache persisted in ~/.chronos/@p fileName
+static shared_ptr<SharedCertificateCache>
+makeCertificateCache(const string& fileName)
+{
+  boost::filesystem::path chronosDir = boost::filesystem::path(getenv("HOME")) / ".chronos";
+  boost::filesystem::create_directories(chronosDir);
+  return make_shared<SharedCertificateCache>((chronosDir / fileName).string());
+}
+
+/// @brief The anchor shared by all the policies
+static shared_ptr<IdentityCertificate>
+getTrustAnchor()
+{
+  static shared_ptr<IdentityCertificate> anchor = loadTrustAnchor();
+  return anchor;
+}
+
+shared_ptr<const ValidationPolicy>
+ValidationPolicy::getChatPolicy()
+{
+  static shared_ptr<const ValidationPolicy> policy = [] {
+    Rules rules;
+    rules.push_back(makeRule("^<>*<%F0.>(<>*)$",
+                             "^([^<KEY>]*)<KEY>(<>*)<ksk-.*><ID-CERT>$",
+                             ">", "\\1", "\\1\\2"));
+    rules.push_back(makeRule("(<>*)$",
+                             "^([^<KEY>]*)<KEY>(<>*)<ksk-.*><ID-CERT>$",
+                             ">", "\\1", "\\1\\2"));
+    return make_shared<ValidationPolicy>(getTrustAnchor(), rules,
+                                         makeCertificateCache("chat-certificates.cache"));
+  }();
+
+  return policy;
+}
+
+shared_ptr<const ValidationPolicy>
+ValidationPolicy::getContactPolicy()
+{
+  static shared_ptr<const ValidationPolicy> policy = [] {
+    Rules rules;
+    rules.push_back(makeRule("^([^<DNS>]*)<DNS><ENDORSED>",
+                             "^([^<KEY>]*)<KEY>(<>*)<><ID-CERT>$",
+                             "==", "\\1", "\\1\\2"));
+    rules.push_back(makeRule("^([^<DNS>]*)<DNS><><ENDORSEE>",
+                             "^([^<KEY>]*)<KEY>(<>*)<><ID-CERT>$",
+                             "==", "\\1", "\\1\\2"));
+    rules.push_back(makeRule("^([^<DNS>]*)<DNS><PROFILE>",
+                             "^([^<KEY>]*)<KEY>(<>*)<><ID-CERT>$",
+                             "==", "\\1", "\\1\\2"));
+    rules.push_back(makeRule("^([^<PROFILE-CERT>]*)<PROFILE-CERT>",
+                             "^([^<KEY>]*)<KEY>(<>*<ksk-.*>)<ID-CERT>$",
+                             "==", "\\1", "\\1\\2"));
+    rules.push_back(makeRule("^([^<KEY>]*)<KEY>(<>*)<ksk-.*><ID-CERT>",
+                             "^([^<KEY>]*)<KEY><dsk-.*><ID-CERT>$",
+                             ">", "\\1\\2", "\\1"));
+    rules.push_back(makeRule("^([^<KEY>]*)<KEY><dsk-.*><ID-CERT>",
+                             "^([^<KEY>]*)<KEY>(<>*)<ksk-.*><ID-CERT>$",
+                             "==", "\\1", "\\1\\2"));
+    rules.push_back(makeRule("^(<>*)$",
+                             "^([^<KEY>]*)<KEY>(<>*)<ksk-.*><ID-CERT>$",
+                             ">", "\\1", "\\1\\2"));
+    return make_shared<ValidationPolicy>(getTrustAnchor(), rules,
+                                         makeCertificateCache("contact-certificates.cache"));
+  }();
+
+  return policy;
+}
+
+ValidationPolicy::ValidationPolicy(const shared_ptr<IdentityCertificate>& anchor,
+                                   const Rules& rules,
+                                   const shared_ptr<SharedCertificateCache>& cache)
+  : m_anchor(anchor)
+  , m_rules(rules)
+  , m_cache(cache)
+{
+}
+
+shared_ptr<ndn::ValidatorRegex>
+ValidationPolicy::makeValidator(ndn::Face& face) const
+{
+  shared_ptr<ndn::ValidatorRegex> validator =
+    make_shared<ndn::ValidatorRegex>(boost::ref(face), m_cache);
+
+  for (Rules::const_iterator it = m_rules.begin(); it != m_rules.end(); it++)
+    validator->addDataVerificationRule(*it);
+
+  if (static_cast<bool>(m_anchor))
+    validator->addTrustAnchor(m_anchor);
+
+  return validator;
+}
+
+} // namespace chronochat
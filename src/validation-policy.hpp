@@ -0,0 +1,80 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#ifndef CHRONOCHAT_VALIDATION_POLICY_HPP
+#define CHRONOCHAT_VALIDATION_POLICY_HPP
+
+#include "common.hpp"
+#include "shared-certificate-cache.hpp"
+
+#include <ndn-cxx/face.hpp>
+#include <ndn-cxx/security/validator-regex.hpp>
+
+namespace chronochat {
+
+/**
+ * @brief The trust anchor and verification rules of a kind of validator
+ *
+ * Each policy is built once, on first use, and shared by all the validators of the
+ * process that apply it, so joining a chatroom or reconnecting neither reads the anchor
+ * nor compiles rules again.  A policy never changes after it is built and may be used
+ * from any thread.
+ *
+ * Validators trust the certificates in their cache without checking their chain again, so
+ * each policy has a cache of its own: a certificate admitted by the rules of one policy is
+ * never trusted by the validators of another.
+ */
+class ValidationPolicy : noncopyable
+{
+public:
+  typedef std::vector<shared_ptr<ndn::SecRuleRelative> > Rules;
+
+  /// @brief Policy of chatroom data, signed by a key of the prefix of the data
+  static shared_ptr<const ValidationPolicy>
+  getChatPolicy();
+
+  /// @brief Policy of the profiles, endorsements and certificates of contacts
+  static shared_ptr<const ValidationPolicy>
+  getContactPolicy();
+
+  ValidationPolicy(const shared_ptr<ndn::IdentityCertificate>& anchor, const Rules& rules,
+                   const shared_ptr<SharedCertificateCache>& cache);
+
+  /// @return the trust anchor, null if it could not be loaded
+  shared_ptr<const ndn::IdentityCertificate>
+  getTrustAnchor() const
+  {
+    return m_anchor;
+  }
+
+  /// @brief The certificates validated under this policy
+  shared_ptr<SharedCertificateCache>
+  getCertificateCache() const
+  {
+    return m_cache;
+  }
+
+  /**
+   * @brief Create a validator applying this policy, with the cache of the policy
+   *
+   * @param face  face the validator fetches certificates through
+   */
+  shared_ptr<ndn::ValidatorRegex>
+  makeValidator(ndn::Face& face) const;
+
+private:
+  shared_ptr<ndn::IdentityCertificate> m_anchor;
+  Rules m_rules;
+  shared_ptr<SharedCertificateCache> m_cache;
+};
+
+} // namespace chronochat
+
+#endif // CHRONOCHAT_VALIDATION_POLICY_HPP
@@ -0,0 +1,155 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "cert-directory-fetcher.hpp"
+#include <thread>
+
+namespace chronochat {
+namespace tests {
+
+using std::string;
+using std::vector;
+using boost::asio::ip::tcp;
+
+/**
+ * @brief A local stand-in for the certificate directory
+ *
+ * Answers a single request with @p response, sent in the given chunks, then closes the
+ * connection, or keeps it open without answering if @p chunks is empty.
+ */
+class DirectoryServer
+{
+public:
+  explicit
+  DirectoryServer(const vector<string>& chunks)
+    : m_acceptor(m_ioService, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0))
+    , m_socket(m_ioService)
+    , m_chunks(chunks)
+  {
+    m_thread = std::thread([this] {
+        m_acceptor.accept(m_socket);
+
+        boost::asio::streambuf request;
+        boost::asio::read_until(m_socket, request, "\r\n\r\n");
+        std::istream is(&request);
+        std::getline(is, m_requestLine);
+
+        boost::system::error_code error;
+        for (size_t i = 0; i < m_chunks.size(); i++)
+          boost::asio::write(m_socket, boost::asio::buffer(m_chunks[i]), error);
+        if (!m_chunks.empty())
+          m_socket.close(error);
+      });
+  }
+
+  ~DirectoryServer()
+  {
+    m_thread.join();
+  }
+
+  string
+  getPort() const
+  {
+    return boost::lexical_cast<string>(m_acceptor.local_endpoint().port());
+  }
+
+  const string&
+  getRequestLine() const
+  {
+    return m_requestLine;
+  }
+
+private:
+  boost::asio::io_service m_ioService;
+  tcp::acceptor m_acceptor;
+  tcp::socket m_socket;
+  vector<string> m_chunks;
+  string m_requestLine;
+  std::thread m_thread;
+};
+
+class CertDirectoryFetcherFixture
+{
+public:
+  CertDirectoryFetcherFixture()
+    : m_nDone(0)
+  {
+  }
+
+  void
+  fetch(CertDirectoryFetcher& fetcher)
+  {
+    fetcher.fetch([this] (const string& certName) { m_certNames.push_back(certName); },
+                  [this] { m_nDone++; },
+                  [this] (const string& failInfo) { m_failures.push_back(failInfo); });
+    m_ioService.run();
+  }
+
+protected:
+  boost::asio::io_service m_ioService;
+  vector<string> m_certNames;
+  size_t m_nDone;
+  vector<string> m_failures;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestCertDirectoryFetcher, CertDirectoryFetcherFixture)
+
+BOOST_AUTO_TEST_CASE(StreamedList)
+{
+  vector<string> chunks;
+  chunks.push_back("HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\n\r\n"
+                   "/ndn/alice/KEY/ksk-1/ID-CERT\n");
+  chunks.push_back("\"/ndn/bob/KEY/ksk-2/ID-CERT\"\r\n\n/ndn/ca");
+  chunks.push_back("rol/KEY/ksk-3/ID-CERT");
+  DirectoryServer server(chunks);
+
+  CertDirectoryFetcher fetcher(m_ioService, "127.0.0.1", server.getPort(), "/cert/list/");
+  fetch(fetcher);
+
+  BOOST_CHECK_EQUAL(server.getRequestLine(), "GET /cert/list/ HTTP/1.0\r");
+  BOOST_REQUIRE_EQUAL(m_certNames.size(), 3);
+  BOOST_CHECK_EQUAL(m_certNames[0], "/ndn/alice/KEY/ksk-1/ID-CERT");
+  BOOST_CHECK_EQUAL(m_certNames[1], "/ndn/bob/KEY/ksk-2/ID-CERT");
+  BOOST_CHECK_EQUAL(m_certNames[2], "/ndn/carol/KEY/ksk-3/ID-CERT");
+  BOOST_CHECK_EQUAL(m_nDone, 1);
+  BOOST_CHECK(m_failures.empty());
+}
+
+BOOST_AUTO_TEST_CASE(HttpError)
+{
+  vector<string> chunks;
+  chunks.push_back("HTTP/1.0 404 Not Found\r\n\r\n/ndn/alice/KEY/ksk-1/ID-CERT\n");
+  DirectoryServer server(chunks);
+
+  CertDirectoryFetcher fetcher(m_ioService, "127.0.0.1", server.getPort(), "/cert/list/");
+  fetch(fetcher);
+
+  BOOST_CHECK(m_certNames.empty());
+  BOOST_CHECK_EQUAL(m_nDone, 0);
+  BOOST_CHECK_EQUAL(m_failures.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(Timeout)
+{
+  DirectoryServer server((vector<string>()));
+
+  CertDirectoryFetcher fetcher(m_ioService, "127.0.0.1", server.getPort(), "/cert/list/");
+  fetcher.setTimeout(boost::posix_time::milliseconds(100));
+  fetch(fetcher);
+
+  BOOST_CHECK_EQUAL(m_nDone, 0);
+  BOOST_CHECK_EQUAL(m_failures.size(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace chronochat
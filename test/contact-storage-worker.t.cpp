@@ -0,0 +1,173 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2013 Regents of the University of California.
+ * @author: Yingdi Yu <yingdi@cs.ucla.edu>
+ * See COPYING for copyright and distribution information.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "contact-storage-worker.hpp"
+#include "temporary-home.hpp"
+#include <future>
+
+namespace chronochat {
+namespace tests {
+
+using std::string;
+
+class ContactStorageWorkerFixture
+{
+public:
+  ContactStorageWorkerFixture()
+    : m_home("TestContactStorageWorker")
+  {
+  }
+
+  void
+  onFailure(const string& failInfo)
+  {
+    m_failures.push_back(failInfo);
+  }
+
+  /// @brief Deliver the callbacks of the operations queued on @p worker so far
+  void
+  deliverCallbacks(ContactStorageWorker& worker)
+  {
+    // callbacks are posted in order, the one of this write comes last
+    boost::asio::io_service::work work(m_ioService);
+    worker.write([] (ContactStorage&) {},
+                 [this] { m_ioService.stop(); },
+                 [this] (const string&) { m_ioService.stop(); });
+    m_ioService.run();
+    m_ioService.reset();
+  }
+
+protected:
+  TemporaryHome m_home;
+  boost::asio::io_service m_ioService;
+  std::vector<string> m_failures;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestContactStorageWorker, ContactStorageWorkerFixture)
+
+BOOST_AUTO_TEST_CASE(NotOpen)
+{
+  bool hasResult = false;
+  ContactStorageWorker worker(m_ioService,
+                              bind(&ContactStorageWorkerFixture::onFailure, this, _1));
+  worker.query<shared_ptr<Profile> >(
+    [] (ContactStorage& storage) { return storage.getSelfProfile(); },
+    [&] (const shared_ptr<Profile>&) { hasResult = true; });
+  deliverCallbacks(worker);
+
+  BOOST_CHECK(!hasResult);
+  BOOST_CHECK_EQUAL(m_failures.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(OrderAndCoalescing)
+{
+  std::promise<void> start;
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::vector<int> writes;
+  std::vector<int> reads;
+
+  ContactStorageWorker worker(m_ioService,
+                              bind(&ContactStorageWorkerFixture::onFailure, this, _1));
+  worker.open(Name("/TestContactStorageWorker"));
+
+  // hold the worker so the following writes stay queued
+  worker.write([&start, released] (ContactStorage&) {
+      start.set_value();
+      released.wait();
+    });
+  start.get_future().wait();
+
+  for (int i = 0; i < 3; i++)
+    worker.write("key", [&writes, i] (ContactStorage&) { writes.push_back(i); });
+  worker.write("other", [&writes] (ContactStorage&) { writes.push_back(10); });
+  worker.query<int>([&writes] (ContactStorage&) { return writes.size(); },
+                    [&reads] (const int& nWrites) { reads.push_back(nWrites); });
+
+  BOOST_CHECK_EQUAL(worker.getQueueSize(), 3);
+  release.set_value();
+  deliverCallbacks(worker);
+
+  BOOST_REQUIRE_EQUAL(writes.size(), 2);
+  BOOST_CHECK_EQUAL(writes[0], 2);
+  BOOST_CHECK_EQUAL(writes[1], 10);
+  BOOST_REQUIRE_EQUAL(reads.size(), 1);
+  BOOST_CHECK_EQUAL(reads[0], 2);
+  BOOST_CHECK(m_failures.empty());
+}
+
+BOOST_AUTO_TEST_CASE(FullQueue)
+{
+  std::promise<void> start;
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::vector<int> writes;
+  std::vector<int> reads;
+  size_t nRefused = 0;
+
+  ContactStorageWorker worker(m_ioService,
+                              bind(&ContactStorageWorkerFixture::onFailure, this, _1), 2);
+  worker.open(Name("/TestContactStorageWorker"));
+  worker.write([&start, released] (ContactStorage&) {
+      start.set_value();
+      released.wait();
+    });
+  start.get_future().wait();
+
+  worker.write("key", [&writes] (ContactStorage&) { writes.push_back(0); });
+  worker.tryQuery<int>([] (ContactStorage&) { return 1; },
+                       [&reads] (const int& i) { reads.push_back(i); },
+                       [&nRefused] (const string&) { nRefused++; });
+  // the queue is full: reads are refused, writes and queries are not
+  worker.tryQuery<int>([] (ContactStorage&) { return 2; },
+                       [&reads] (const int& i) { reads.push_back(i); },
+                       [&nRefused] (const string&) { nRefused++; });
+  worker.write([&writes] (ContactStorage&) { writes.push_back(3); });
+  worker.write("key", [&writes] (ContactStorage&) { writes.push_back(4); });
+  worker.query<int>([] (ContactStorage&) { return 5; },
+                    [&reads] (const int& i) { reads.push_back(i); });
+
+  BOOST_CHECK_EQUAL(worker.getQueueSize(), 4);
+  release.set_value();
+  deliverCallbacks(worker);
+
+  BOOST_REQUIRE_EQUAL(writes.size(), 2);
+  BOOST_CHECK_EQUAL(writes[0], 4);
+  BOOST_CHECK_EQUAL(writes[1], 3);
+  BOOST_REQUIRE_EQUAL(reads.size(), 2);
+  BOOST_CHECK_EQUAL(reads[0], 1);
+  BOOST_CHECK_EQUAL(reads[1], 5);
+  BOOST_CHECK_EQUAL(nRefused, 1);
+  BOOST_CHECK(m_failures.empty());
+}
+
+BOOST_AUTO_TEST_CASE(Stop)
+{
+  bool hasWritten = false;
+  bool hasResult = false;
+
+  ContactStorageWorker worker(m_ioService,
+                              bind(&ContactStorageWorkerFixture::onFailure, this, _1));
+  worker.open(Name("/TestContactStorageWorker"));
+  worker.stop();
+
+  worker.write([&hasWritten] (ContactStorage&) { hasWritten = true; });
+  worker.query<int>([] (ContactStorage&) { return 0; },
+                    [&hasResult] (const int&) { hasResult = true; });
+  m_ioService.run();
+
+  BOOST_CHECK(!hasWritten);
+  BOOST_CHECK(!hasResult);
+  BOOST_CHECK(m_failures.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace chronochat
@@ -9,12 +9,19 @@
 
 #include "contact-storage.hpp"
 #include "cryptopp.hpp"
+#include "temporary-home.hpp"
+#include <ndn-cxx/util/io.hpp>
+#include <ndn-cxx/security/key-chain.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/iostreams/device/array.hpp>
 #include <boost/filesystem.hpp>
 
 namespace chronochat {
 namespace tests {
 
 using std::string;
+using std::vector;
+using ndn::IdentityCertificate;
 namespace fs = boost::filesystem;
 
 BOOST_AUTO_TEST_SUITE(TestContactStorage)
@@ -31,6 +38,221 @@ BOOST_AUTO_TEST_CASE(InitializeTable)
   BOOST_CHECK(boost::filesystem::exists(dbPath));
 }
 
+
+const string testIdCert("\
+Bv0DXwdRCBdFbmRvcnNlQ2VydGlmaWNhdGVUZXN0cwgDS0VZCAxFbmNvZGVEZWNv\
+ZGUIEWtzay0xMzk0MDcyMTQ3MzM1CAdJRC1DRVJUCAf9AUSVLNXoFAMYAQIV/QG8\
+MIIBuDAiGA8yMDE0MDMwNjAyMTU0N1oYDzIwMTQwMzEzMDkyNzQ3WjBuMA0GA1UE\
+KRMGTXlOYW1lMBIGA1UECxMLTXlJbnN0aXR1dGUwDgYDVQQBEwdNeUdyb3VwMBEG\
+A1UEAxMKTXlIb21lUGFnZTAQBgNVBFATCU15QWR2aXNvcjAUBgkqhkiG9w0BCQET\
+B015RW1haWwwggEgMA0GCSqGSIb3DQEBAQUAA4IBDQAwggEIAoIBAQDYsWD0ixQF\
+RfYs36BHNsRNv5ouEL69oaS6XX/hsQN1By4RNI6eSG5DpajtAwK1y+DXPwkLHd5S\
+BrvwLzReF7SsrF2ObawznU14GKaQdbn+eVIER7CWvSpJhH5yKS4fCPRN+b1MP8QS\
+DLvaaGu15T98cgVscIEqFkLfnWSQbdN6EnodjOH27JkBCz8Lxv9GZLrhfKGzOylR\
+fLzvCIyIXYl6HWroO+xTJQaP+miSZNVGyf4jYqz5WbQH56a9ZjUldTphjuDbBjUq\
+QaNVOzoKT+H4qh8mn399aQ9/BjM+6/WgrSw7/MO2UCgoZhySQY4HVqzUVVWnYwOU\
+NYPoOS3HdvGLAgERFkEbAQEcPAc6CBdFbmRvcnNlQ2VydGlmaWNhdGVUZXN0cwgD\
+S0VZCBFrc2stMTM5NDA3MjE0NzEyOAgHSUQtQ0VSVBf9AQARSwS/CelRRSUO4Tik\
+5Q+L5zusaqq5652T92/83S5l38dO41BOf5fBUb3RtnFSbS/QaBCRfRJtDvkN2LhE\
+vksJjSAoAKUzx27UyM1eq7L8DDvsvC9mbwxGzTK2F1t3Jy81rk5X34MecvztlILs\
+nLqzqqiwl3dS1xyvg9GZez5g1yoOtRwzkHaah6svLVwzwM7kECXWRf4NoHTazWQo\
+Cs6s60F9I/xBRKJ4Cw2L/AzvB5sX1J4HvHCsplbR/GdvA8uW6i8pp7kjIhjCGewK\
+uNfH/4lHxzTl3pjsVy+EHKmwSlZ+T8cy5qaIEHxhbOzMNNVdit7XEwexOE66AVza\
+92On");
+
+
+class ContactStorageFixture
+{
+public:
+  ContactStorageFixture()
+    : m_home("TestContactStorage")
+  {
+    boost::iostreams::stream<boost::iostreams::array_source> is(testIdCert.c_str(),
+                                                                testIdCert.size());
+    m_key = ndn::io::load<IdentityCertificate>(is)->getPublicKeyInfo();
+  }
+
+  shared_ptr<Contact>
+  makeContact(const Name& identity, bool isIntroducer = false)
+  {
+    return make_shared<Contact>(identity, "alias", Name(identity).append("ksk-1"),
+                                time::system_clock::now(),
+                                time::system_clock::now() + time::days(365),
+                                m_key, isIntroducer);
+  }
+
+protected:
+  TemporaryHome m_home;
+  ndn::PublicKey m_key;
+};
+
+BOOST_FIXTURE_TEST_CASE(AddContacts, ContactStorageFixture)
+{
+  ContactStorage contactStorage(Name("/TestContactStorage/AddContacts"));
+
+  vector<shared_ptr<Contact> > contacts;
+  for (int i = 0; i < 100; i++)
+    contacts.push_back(makeContact(Name("/TestContactStorage/contact").appendNumber(i)));
+  contactStorage.addContacts(contacts);
+
+  vector<shared_ptr<Contact> > storedContacts;
+  contactStorage.getAllContacts(storedContacts);
+  BOOST_CHECK_EQUAL(storedContacts.size(), 100);
+
+  // a batch with an existing contact is rolled back as a whole
+  vector<shared_ptr<Contact> > newContacts;
+  newContacts.push_back(makeContact(Name("/TestContactStorage/new")));
+  newContacts.push_back(contacts[0]);
+  BOOST_CHECK_THROW(contactStorage.addContacts(newContacts), ContactStorage::Error);
+
+  storedContacts.clear();
+  contactStorage.getAllContacts(storedContacts);
+  BOOST_CHECK_EQUAL(storedContacts.size(), 100);
+
+  contactStorage.removeContact(contacts[0]->getNameSpace());
+  storedContacts.clear();
+  contactStorage.getAllContacts(storedContacts);
+  BOOST_CHECK_EQUAL(storedContacts.size(), 99);
+
+  contactStorage.addContact(*contacts[0]);
+  storedContacts.clear();
+  contactStorage.getAllContacts(storedContacts);
+  BOOST_CHECK_EQUAL(storedContacts.size(), 100);
+}
+
+BOOST_FIXTURE_TEST_CASE(GetAllContacts, ContactStorageFixture)
+{
+  ContactStorage contactStorage(Name("/TestContactStorage/GetAllContacts"));
+
+  vector<shared_ptr<Contact> > contacts;
+  for (int i = 0; i < 10; i++) {
+    Name identity = Name("/TestContactStorage/contact").appendNumber(i);
+    shared_ptr<Contact> contact = makeContact(identity, i % 2 == 0);
+
+    Profile profile;
+    profile["name"] = identity.toUri();
+    contact->setProfile(profile);
+    contact->addTrustScope(identity);
+    contacts.push_back(contact);
+  }
+  contactStorage.addContacts(contacts);
+
+  vector<shared_ptr<Contact> > storedContacts;
+  contactStorage.getAllContacts(storedContacts);
+  BOOST_REQUIRE_EQUAL(storedContacts.size(), 10);
+
+  for (vector<shared_ptr<Contact> >::iterator it = storedContacts.begin();
+       it != storedContacts.end(); it++) {
+    shared_ptr<Contact> contact = contactStorage.getContact((*it)->getNameSpace());
+    BOOST_CHECK_EQUAL((*it)->getName(), (*it)->getNameSpace().toUri());
+    BOOST_CHECK_EQUAL((*it)->getName(), contact->getName());
+    BOOST_CHECK_EQUAL((*it)->isIntroducer(), contact->isIntroducer());
+    BOOST_CHECK_EQUAL((*it)->trustScopeBegin() == (*it)->trustScopeEnd(),
+                      !contact->isIntroducer());
+  }
+
+  BOOST_CHECK(!static_cast<bool>(contactStorage.getContact(Name("/TestContactStorage/none"))));
+}
+
+static string
+sha256(const Block& block)
+{
+  std::stringstream ss;
+  {
+    using namespace CryptoPP;
+    SHA256 hash;
+
+    StringSource(block.wire(), block.size(), true, new HashFilter(hash, new FileSink(ss)));
+  }
+  return ss.str();
+}
+
+BOOST_FIXTURE_TEST_CASE(CollectEndorse, ContactStorageFixture)
+{
+  Name identity("/TestContactStorage/CollectEndorse");
+  std::map<Name, string> hashes;
+  {
+    ContactStorage contactStorage(identity);
+    unique_ptr<ndn::KeyChain> keyChain = m_home.makeKeyChain();
+
+    vector<shared_ptr<EndorseCertificate> > certificates;
+    for (int i = 0; i < 3; i++) {
+      Name signer = Name("/TestContactStorage/endorser").appendNumber(i).append("ksk-1");
+      shared_ptr<EndorseCertificate> certificate =
+        make_shared<EndorseCertificate>(Name(identity).append("ksk-1"), m_key,
+                                        time::system_clock::now(),
+                                        time::system_clock::now() + time::days(365),
+                                        signer, Profile(identity));
+      keyChain->signWithSha256(*certificate);
+      certificates.push_back(certificate);
+      hashes[certificate->getName()] = sha256(certificate->wireEncode());
+    }
+    contactStorage.updateCollectEndorse(certificates);
+
+    EndorseCollection collection;
+    contactStorage.getCollectEndorse(collection);
+    BOOST_REQUIRE_EQUAL(collection.getCollectionEntries().size(), 3);
+    for (size_t i = 0; i < collection.getCollectionEntries().size(); i++) {
+      const EndorseCollection::CollectionEntry& entry = collection.getCollectionEntries()[i];
+      BOOST_CHECK(entry.hash == hashes[entry.certName]);
+    }
+  }
+
+  // a table from before the hash column is upgraded when the storage is opened
+  fs::path dbPath = m_home.getPath() / ".chronos" / "unknown";
+  for (fs::directory_iterator it(m_home.getPath() / ".chronos"); it != fs::directory_iterator();
+       it++)
+    if (it->path().extension() == ".db")
+      dbPath = it->path();
+
+  sqlite3* db;
+  BOOST_REQUIRE_EQUAL(sqlite3_open(dbPath.c_str(), &db), SQLITE_OK);
+  BOOST_REQUIRE_EQUAL(sqlite3_exec(db,
+                                   "CREATE TABLE OldCollectEndorse AS \
+                                    SELECT endorser, endorse_name, endorse_data \
+                                    FROM CollectEndorse; \
+                                    DROP TABLE CollectEndorse; \
+                                    ALTER TABLE OldCollectEndorse RENAME TO CollectEndorse;",
+                                   NULL, NULL, NULL),
+                      SQLITE_OK);
+  sqlite3_close(db);
+
+  ContactStorage contactStorage(identity);
+  EndorseCollection collection;
+  contactStorage.getCollectEndorse(collection);
+  BOOST_REQUIRE_EQUAL(collection.getCollectionEntries().size(), 3);
+  for (size_t i = 0; i < collection.getCollectionEntries().size(); i++) {
+    const EndorseCollection::CollectionEntry& entry = collection.getCollectionEntries()[i];
+    BOOST_CHECK(entry.hash == hashes[entry.certName]);
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(CollectEndorseVersions, ContactStorageFixture)
+{
+  Name identity("/TestContactStorage/CollectEndorseVersions");
+  ContactStorage contactStorage(identity);
+  unique_ptr<ndn::KeyChain> keyChain = m_home.makeKeyChain();
+
+  Name endorser("/TestContactStorage/endorser");
+  EndorseCertificate certificate(Name(identity).append("ksk-1"), m_key,
+                                 time::system_clock::now(),
+                                 time::system_clock::now() + time::days(365),
+                                 Name(endorser).append("ksk-1"), Profile(identity));
+  keyChain->signWithSha256(certificate);
+
+  contactStorage.updateCollectEndorse(certificate, endorser, 1);
+  contactStorage.updateCollectEndorse(certificate, endorser, 2);
+
+  std::map<Name, uint64_t> versions;
+  contactStorage.getCollectEndorseVersions(versions);
+  BOOST_REQUIRE_EQUAL(versions.size(), 1);
+  BOOST_CHECK_EQUAL(versions[endorser], 2);
+
+  EndorseCollection collection;
+  contactStorage.getCollectEndorse(collection);
+  BOOST_CHECK_EQUAL(collection.getCollectionEntries().size(), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace tests
@@ -0,0 +1,81 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "lru-cache.hpp"
+#include <boost/thread/thread.hpp>
+
+namespace chronochat {
+namespace tests {
+
+using std::string;
+
+BOOST_AUTO_TEST_SUITE(TestLruCache)
+
+BOOST_AUTO_TEST_CASE(InsertFind)
+{
+  LruCache<string, int> cache(4, time::seconds(60));
+  BOOST_CHECK(cache.find("alice") == 0);
+
+  cache.insert("alice", 1);
+  cache.insert("bob", 2);
+  BOOST_REQUIRE(cache.find("alice") != 0);
+  BOOST_CHECK_EQUAL(*cache.find("alice"), 1);
+
+  cache.insert("alice", 3);
+  BOOST_CHECK_EQUAL(*cache.find("alice"), 3);
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+
+  *cache.find("bob") = 4;
+  BOOST_CHECK_EQUAL(*cache.find("bob"), 4);
+
+  cache.erase("alice");
+  BOOST_CHECK(cache.find("alice") == 0);
+  BOOST_CHECK_EQUAL(cache.size(), 1);
+
+  cache.clear();
+  BOOST_CHECK(cache.find("bob") == 0);
+  BOOST_CHECK_EQUAL(cache.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Eviction)
+{
+  LruCache<string, int> cache(2, time::seconds(60));
+  cache.insert("alice", 1);
+  cache.insert("bob", 2);
+
+  // alice is now more recently used than bob
+  BOOST_CHECK(cache.find("alice") != 0);
+  cache.insert("carol", 3);
+
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK(cache.find("bob") == 0);
+  BOOST_CHECK(cache.find("alice") != 0);
+  BOOST_CHECK(cache.find("carol") != 0);
+}
+
+BOOST_AUTO_TEST_CASE(Expiry)
+{
+  LruCache<string, int> cache(4, time::milliseconds(50));
+  cache.insert("alice", 1);
+  BOOST_CHECK(cache.find("alice") != 0);
+
+  boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+  cache.insert("bob", 2);
+
+  BOOST_CHECK(cache.find("alice") == 0);
+  BOOST_CHECK(cache.find("bob") != 0);
+  BOOST_CHECK_EQUAL(cache.size(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace chronochat
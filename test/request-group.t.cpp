@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "request-group.hpp"
+
+namespace chronochat {
+namespace tests {
+
+using std::vector;
+
+class RequestGroupFixture
+{
+public:
+  RequestGroupFixture()
+    : m_group(m_ioService, 2)
+    , m_nInFlight(0)
+    , m_maxInFlight(0)
+  {
+  }
+
+  void
+  start(const boost::posix_time::time_duration& deadline = boost::posix_time::pos_infin)
+  {
+    m_group.start([this] (size_t nDone, size_t nTotal) { m_progress.push_back(nDone); },
+                  [this] (bool isComplete) { m_results.push_back(isComplete); },
+                  deadline);
+  }
+
+  /// @brief A request that completes on the next turn of the io_service
+  void
+  addDeferred()
+  {
+    m_group.add([this] (const RequestGroup::Completion& done) {
+        m_nInFlight++;
+        m_maxInFlight = std::max(m_maxInFlight, m_nInFlight);
+        m_ioService.post([this, done] {
+            m_nInFlight--;
+            done();
+          });
+      });
+  }
+
+  /// @brief A request that is kept until the test completes it
+  void
+  addHeld()
+  {
+    m_group.add([this] (const RequestGroup::Completion& done) { m_held.push_back(done); });
+  }
+
+protected:
+  boost::asio::io_service m_ioService;
+  RequestGroup m_group;
+
+  size_t m_nInFlight;
+  size_t m_maxInFlight;
+  vector<RequestGroup::Completion> m_held;
+  vector<size_t> m_progress;
+  vector<bool> m_results;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestRequestGroup, RequestGroupFixture)
+
+BOOST_AUTO_TEST_CASE(ConcurrencyCap)
+{
+  start();
+  for (int i = 0; i < 5; i++)
+    addDeferred();
+  m_group.close();
+
+  BOOST_CHECK_EQUAL(m_nInFlight, 2);
+  m_ioService.run();
+
+  BOOST_CHECK_EQUAL(m_maxInFlight, 2);
+  BOOST_REQUIRE_EQUAL(m_progress.size(), 5);
+  BOOST_CHECK_EQUAL(m_progress.back(), 5);
+  BOOST_REQUIRE_EQUAL(m_results.size(), 1);
+  BOOST_CHECK_EQUAL(m_results[0], true);
+  BOOST_CHECK(!m_group.isRunning());
+}
+
+BOOST_AUTO_TEST_CASE(SynchronousCompletion)
+{
+  start();
+  for (int i = 0; i < 1000; i++)
+    m_group.add([] (const RequestGroup::Completion& done) { done(); });
+
+  BOOST_CHECK_EQUAL(m_progress.size(), 1000);
+  BOOST_CHECK(m_results.empty());
+
+  m_group.close();
+  BOOST_REQUIRE_EQUAL(m_results.size(), 1);
+  BOOST_CHECK_EQUAL(m_results[0], true);
+}
+
+BOOST_AUTO_TEST_CASE(CloseWhileInFlight)
+{
+  start();
+  addHeld();
+  m_group.close();
+  BOOST_CHECK(m_results.empty());
+
+  m_held[0]();
+  m_held[0]();
+  BOOST_CHECK_EQUAL(m_progress.size(), 1);
+  BOOST_REQUIRE_EQUAL(m_results.size(), 1);
+  BOOST_CHECK_EQUAL(m_results[0], true);
+}
+
+BOOST_AUTO_TEST_CASE(OverlappingRounds)
+{
+  start();
+  addHeld();
+  addHeld();
+  BOOST_CHECK(m_held[0].isCurrent());
+
+  start();
+  BOOST_CHECK(!m_held[0].isCurrent());
+  addHeld();
+  m_group.close();
+
+  // completions of the superseded round are ignored
+  m_held[0]();
+  m_held[1]();
+  BOOST_CHECK(m_progress.empty());
+  BOOST_CHECK(m_results.empty());
+
+  m_held[2]();
+  BOOST_CHECK_EQUAL(m_progress.size(), 1);
+  BOOST_REQUIRE_EQUAL(m_results.size(), 1);
+  BOOST_CHECK_EQUAL(m_results[0], true);
+}
+
+BOOST_AUTO_TEST_CASE(Cancel)
+{
+  start();
+  addHeld();
+  addHeld();
+  addHeld();
+  m_group.cancel();
+
+  BOOST_CHECK_EQUAL(m_held.size(), 2);
+  m_held[0]();
+  m_group.close();
+  addHeld();
+
+  BOOST_CHECK_EQUAL(m_held.size(), 2);
+  BOOST_CHECK(m_progress.empty());
+  BOOST_CHECK(m_results.empty());
+}
+
+BOOST_AUTO_TEST_CASE(Deadline)
+{
+  start(boost::posix_time::milliseconds(50));
+  addHeld();
+  addHeld();
+  addHeld();
+  m_held[0]();
+  m_group.close();
+
+  m_ioService.run();
+
+  BOOST_REQUIRE_EQUAL(m_results.size(), 1);
+  BOOST_CHECK_EQUAL(m_results[0], false);
+  BOOST_CHECK_EQUAL(m_held.size(), 3);
+
+  m_held[1]();
+  BOOST_CHECK_EQUAL(m_progress.size(), 1);
+  BOOST_CHECK_EQUAL(m_results.size(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace chronochat
@@ -0,0 +1,138 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "shared-certificate-cache.hpp"
+#include "temporary-home.hpp"
+#include <fstream>
+
+namespace chronochat {
+namespace tests {
+
+using std::string;
+using ndn::IdentityCertificate;
+namespace fs = boost::filesystem;
+
+class SharedCertificateCacheFixture
+{
+public:
+  SharedCertificateCacheFixture()
+    : m_home("TestSharedCertificateCache")
+    , m_path((m_home.getPath() / "certificates.cache").string())
+    , m_keyChain(m_home.makeKeyChain())
+  {
+    Name certName = m_keyChain->createIdentity(Name("/TestSharedCertificateCache"));
+    m_key = m_keyChain->getCertificate(certName)->getPublicKeyInfo();
+  }
+
+  shared_ptr<IdentityCertificate>
+  makeCertificate(const string& identity, const time::system_clock::TimePoint& notAfter)
+  {
+    Name certName(identity);
+    certName.append("KEY").append("ksk-1").append("ID-CERT").appendVersion();
+
+    shared_ptr<IdentityCertificate> certificate = make_shared<IdentityCertificate>();
+    certificate->setName(certName);
+    certificate->setNotBefore(time::system_clock::now() - time::days(1));
+    certificate->setNotAfter(notAfter);
+    certificate->setPublicKeyInfo(m_key);
+    certificate->encode();
+    m_keyChain->signWithSha256(*certificate);
+    return certificate;
+  }
+
+protected:
+  TemporaryHome m_home;
+  string m_path;
+  unique_ptr<ndn::KeyChain> m_keyChain;
+  ndn::PublicKey m_key;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestSharedCertificateCache, SharedCertificateCacheFixture)
+
+BOOST_AUTO_TEST_CASE(Expiry)
+{
+  SharedCertificateCache cache;
+  shared_ptr<IdentityCertificate> valid =
+    makeCertificate("/alice", time::system_clock::now() + time::days(1));
+  shared_ptr<IdentityCertificate> expired =
+    makeCertificate("/bob", time::system_clock::now() - time::seconds(1));
+
+  cache.insertCertificate(valid);
+  cache.insertCertificate(expired);
+
+  BOOST_CHECK_EQUAL(cache.getSize(), 1);
+  BOOST_REQUIRE(static_cast<bool>(cache.getCertificate(valid->getName().getPrefix(-1))));
+  BOOST_CHECK(cache.getCertificate(valid->getName().getPrefix(-1))->wireEncode() ==
+              valid->wireEncode());
+  BOOST_CHECK(!static_cast<bool>(cache.getCertificate(expired->getName().getPrefix(-1))));
+
+  cache.reset();
+  BOOST_CHECK_EQUAL(cache.getSize(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Capacity)
+{
+  SharedCertificateCache cache("", 2);
+  shared_ptr<IdentityCertificate> soon =
+    makeCertificate("/alice", time::system_clock::now() + time::days(1));
+  shared_ptr<IdentityCertificate> later =
+    makeCertificate("/bob", time::system_clock::now() + time::days(3));
+  shared_ptr<IdentityCertificate> latest =
+    makeCertificate("/carol", time::system_clock::now() + time::days(2));
+
+  cache.insertCertificate(soon);
+  cache.insertCertificate(later);
+  cache.insertCertificate(latest);
+
+  // the certificate expiring first makes room
+  BOOST_CHECK_EQUAL(cache.getSize(), 2);
+  BOOST_CHECK(!static_cast<bool>(cache.getCertificate(soon->getName().getPrefix(-1))));
+  BOOST_CHECK(static_cast<bool>(cache.getCertificate(later->getName().getPrefix(-1))));
+  BOOST_CHECK(static_cast<bool>(cache.getCertificate(latest->getName().getPrefix(-1))));
+}
+
+BOOST_AUTO_TEST_CASE(Persistence)
+{
+  shared_ptr<IdentityCertificate> alice =
+    makeCertificate("/alice", time::system_clock::now() + time::days(1));
+  shared_ptr<IdentityCertificate> bob =
+    makeCertificate("/bob", time::system_clock::now() + time::days(1));
+  {
+    SharedCertificateCache cache(m_path);
+    cache.insertCertificate(alice);
+    cache.insertCertificate(bob);
+  }
+
+  // a record cut short at the end of the file is ignored
+  {
+    std::ofstream os(m_path.c_str(), std::ios::binary | std::ios::app);
+    const Block& wire = alice->wireEncode();
+    os.write(reinterpret_cast<const char*>(wire.wire()), wire.size() / 2);
+  }
+
+  {
+    SharedCertificateCache cache(m_path);
+    BOOST_CHECK_EQUAL(cache.getSize(), 2);
+    BOOST_REQUIRE(static_cast<bool>(cache.getCertificate(alice->getName().getPrefix(-1))));
+    BOOST_CHECK(cache.getCertificate(alice->getName().getPrefix(-1))->wireEncode() ==
+                alice->wireEncode());
+    BOOST_CHECK(static_cast<bool>(cache.getCertificate(bob->getName().getPrefix(-1))));
+  }
+
+  // the file was compacted after load, by the time the cache is gone
+  BOOST_CHECK_EQUAL(fs::file_size(m_path),
+                    alice->wireEncode().size() + bob->wireEncode().size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace chronochat
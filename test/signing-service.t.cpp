@@ -0,0 +1,181 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2013 Regents of the University of California.
+ * @author: Yingdi Yu <yingdi@cs.ucla.edu>
+ * See COPYING for copyright and distribution information.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "signing-service.hpp"
+#include "temporary-home.hpp"
+#include <ndn-cxx/security/validator.hpp>
+#include <future>
+
+namespace chronochat {
+namespace tests {
+
+using std::string;
+using ndn::IdentityCertificate;
+
+class SigningServiceFixture
+{
+public:
+  SigningServiceFixture()
+    : m_home("TestSigningService")
+  {
+  }
+
+  void
+  onFailure(const string& failInfo)
+  {
+    m_failures.push_back(failInfo);
+  }
+
+protected:
+  TemporaryHome m_home;
+  boost::asio::io_service m_ioService;
+  std::vector<string> m_failures;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestSigningService, SigningServiceFixture)
+
+BOOST_AUTO_TEST_CASE(Sign)
+{
+  Name identity("/TestSigningService");
+  shared_ptr<Data> data = make_shared<Data>(Name("/TestSigningService/data"));
+  data->setContent(reinterpret_cast<const uint8_t*>("hello"), 5);
+
+  shared_ptr<IdentityCertificate> certificate;
+  bool isSigned = false;
+  {
+    SigningService service(m_home.makeKeyChain());
+    service.call<Name>([&identity] (ndn::KeyChain& keyChain) {
+        return keyChain.createIdentity(identity);
+      });
+
+    service.getCertificate(identity, m_ioService,
+                           [&] (const shared_ptr<IdentityCertificate>& cert) {
+                             certificate = cert;
+                           });
+    service.sign(data, identity, m_ioService, [&] { isSigned = true; },
+                 bind(&SigningServiceFixture::onFailure, this, _1));
+  }
+  m_ioService.run();
+
+  BOOST_CHECK(m_failures.empty());
+  BOOST_REQUIRE(static_cast<bool>(certificate));
+  BOOST_REQUIRE(isSigned);
+  BOOST_CHECK_EQUAL(data->getSignature().getKeyLocator().getName(), certificate->getName());
+  BOOST_CHECK(ndn::Validator::verifySignature(*data, certificate->getPublicKeyInfo()));
+}
+
+BOOST_AUTO_TEST_CASE(UnknownIdentity)
+{
+  shared_ptr<Data> data = make_shared<Data>(Name("/TestSigningService/data"));
+  bool isSigned = false;
+  {
+    SigningService service(m_home.makeKeyChain());
+    service.sign(data, Name("/TestSigningService/Unknown"), m_ioService,
+                 [&] { isSigned = true; },
+                 bind(&SigningServiceFixture::onFailure, this, _1));
+  }
+  m_ioService.run();
+
+  BOOST_CHECK(!isSigned);
+  BOOST_CHECK_EQUAL(m_failures.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(Order)
+{
+  Name identity("/TestSigningService");
+  std::vector<int> results;
+  {
+    SigningService service(m_home.makeKeyChain());
+    service.call<Name>([&identity] (ndn::KeyChain& keyChain) {
+        return keyChain.createIdentity(identity);
+      });
+
+    // more than a batch
+    for (int i = 0; i < 40; i++) {
+      shared_ptr<Data> data = make_shared<Data>(Name("/TestSigningService/data").appendNumber(i));
+      service.sign(data, identity, m_ioService, [&results, i] { results.push_back(i); });
+    }
+    service.query<int>([] (ndn::KeyChain&) { return 40; }, m_ioService,
+                       [&results] (const int& i) { results.push_back(i); });
+  }
+  m_ioService.run();
+
+  BOOST_REQUIRE_EQUAL(results.size(), 41);
+  for (int i = 0; i < 41; i++)
+    BOOST_CHECK_EQUAL(results[i], i);
+}
+
+BOOST_AUTO_TEST_CASE(FullQueue)
+{
+  std::promise<void> isRunning;
+  std::promise<void> canReturn;
+  std::shared_future<void> canReturnFuture = canReturn.get_future().share();
+  std::vector<int> results;
+  {
+    SigningService service(m_home.makeKeyChain(), 1);
+
+    // keep the worker busy, so that the second operation queued after it fills the queue
+    service.query<int>([&isRunning, canReturnFuture] (ndn::KeyChain&) {
+        isRunning.set_value();
+        canReturnFuture.wait();
+        return 0;
+      },
+      m_ioService, [&results] (const int& i) { results.push_back(i); });
+    isRunning.get_future().wait();
+
+    service.query<int>([] (ndn::KeyChain&) { return 1; }, m_ioService,
+                       [&results] (const int& i) { results.push_back(i); });
+    service.query<int>([] (ndn::KeyChain&) { return 2; }, m_ioService,
+                       [&results] (const int& i) { results.push_back(i); },
+                       bind(&SigningServiceFixture::onFailure, this, _1));
+    BOOST_CHECK_THROW(service.call<int>([] (ndn::KeyChain&) { return 3; }),
+                      std::runtime_error);
+    canReturn.set_value();
+  }
+  m_ioService.run();
+
+  BOOST_REQUIRE_EQUAL(results.size(), 2);
+  BOOST_CHECK_EQUAL(results[0], 0);
+  BOOST_CHECK_EQUAL(results[1], 1);
+  BOOST_CHECK_EQUAL(m_failures.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(Cancel)
+{
+  std::promise<void> isRunning;
+  std::promise<void> canReturn;
+  std::shared_future<void> canReturnFuture = canReturn.get_future().share();
+  std::vector<int> results;
+  {
+    SigningService service(m_home.makeKeyChain());
+
+    service.query<int>([&isRunning, canReturnFuture] (ndn::KeyChain&) {
+        isRunning.set_value();
+        canReturnFuture.wait();
+        return 0;
+      },
+      m_ioService, [&results] (const int& i) { results.push_back(i); });
+    isRunning.get_future().wait();
+
+    service.query<int>([] (ndn::KeyChain&) { return 1; }, m_ioService,
+                       [&results] (const int& i) { results.push_back(i); });
+
+    // neither the running operation nor the queued one deliver their result
+    service.cancel(m_ioService);
+    canReturn.set_value();
+  }
+  m_ioService.run();
+
+  BOOST_CHECK(results.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace chronochat
@@ -0,0 +1,66 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2013 Regents of the University of California.
+ * @author: Yingdi Yu <yingdi@cs.ucla.edu>
+ * See COPYING for copyright and distribution information.
+ */
+
+#ifndef CHRONOCHAT_TEST_TEMPORARY_HOME_HPP
+#define CHRONOCHAT_TEST_TEMPORARY_HOME_HPP
+
+#include "common.hpp"
+#include <ndn-cxx/security/key-chain.hpp>
+#include <boost/filesystem.hpp>
+#include <cstdlib>
+
+namespace chronochat {
+namespace tests {
+
+/**
+ * @brief An empty directory under TEST_CERT_PATH that serves as $HOME while it exists
+ *
+ * The directory is removed and $HOME restored on destruction.
+ */
+class TemporaryHome : noncopyable
+{
+public:
+  explicit
+  TemporaryHome(const std::string& name)
+    : m_path(boost::filesystem::path(TEST_CERT_PATH) / name)
+    , m_oldHome(getenv("HOME") != 0 ? getenv("HOME") : "")
+  {
+    boost::filesystem::remove_all(m_path);
+    boost::filesystem::create_directories(m_path);
+    setenv("HOME", m_path.c_str(), 1);
+  }
+
+  ~TemporaryHome()
+  {
+    setenv("HOME", m_oldHome.c_str(), 1);
+    boost::filesystem::remove_all(m_path);
+  }
+
+  const boost::filesystem::path&
+  getPath() const
+  {
+    return m_path;
+  }
+
+  /// @brief A KeyChain kept in the directory, to be destroyed before it
+  unique_ptr<ndn::KeyChain>
+  makeKeyChain() const
+  {
+    return unique_ptr<ndn::KeyChain>(
+      new ndn::KeyChain(std::string("sqlite3:").append(m_path.string()),
+                        std::string("tpm-file:").append(m_path.string())));
+  }
+
+private:
+  boost::filesystem::path m_path;
+  std::string m_oldHome;
+};
+
+} // namespace tests
+} // namespace chronochat
+
+#endif // CHRONOCHAT_TEST_TEMPORARY_HOME_HPP
@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *                     Yingdi Yu
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "trust-graph.hpp"
+#include "tree-layout.hpp"
+
+namespace chronochat {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(TestTrustGraph)
+
+BOOST_AUTO_TEST_CASE(Adjacency)
+{
+  TrustGraph graph;
+  TrustGraph::NodeIndex root = graph.addNode(Name("/ndn"));
+  TrustGraph::NodeIndex ucla = graph.addNode(Name("/ndn/ucla"));
+  TrustGraph::NodeIndex alice = graph.addNode(Name("/ndn/ucla/alice"));
+  TrustGraph::NodeIndex bob = graph.addNode(Name("/ndn/ucla/bob"));
+
+  BOOST_CHECK_EQUAL(graph.addNode(Name("/ndn/ucla")), ucla);
+  BOOST_CHECK_EQUAL(graph.findNode(Name("/ndn/ucla/bob")), bob);
+  BOOST_CHECK_EQUAL(graph.findNode(Name("/ndn/mit")), TrustGraph::INVALID_NODE);
+
+  graph.addEdge(root, ucla);
+  graph.addEdge(ucla, alice);
+  graph.addEdge(ucla, bob);
+  graph.addEdge(alice, bob);
+  BOOST_CHECK_THROW(graph.getIntroducees(root), TrustGraph::Error);
+
+  graph.finalize();
+
+  BOOST_CHECK_EQUAL(graph.size(), 4);
+  BOOST_CHECK_EQUAL(graph.getEdgeCount(), 4);
+  BOOST_CHECK_EQUAL(graph.getIntroducees(root).size(), 1);
+  BOOST_CHECK_EQUAL(graph.getIntroducees(ucla).size(), 2);
+  BOOST_CHECK_EQUAL(graph.getIntroducees(bob).size(), 0);
+  BOOST_CHECK_EQUAL(graph.getIntroducers(bob).size(), 2);
+  BOOST_CHECK_EQUAL(*graph.getIntroducers(alice).begin(), ucla);
+
+  graph.computeLevels();
+  BOOST_CHECK_EQUAL(graph.getLevel(root), 0);
+  BOOST_CHECK_EQUAL(graph.getLevel(ucla), 1);
+  BOOST_CHECK_EQUAL(graph.getLevel(alice), 2);
+  BOOST_CHECK_EQUAL(graph.getLevel(bob), 2);
+}
+
+BOOST_AUTO_TEST_CASE(Cycle)
+{
+  TrustGraph graph;
+  TrustGraph::NodeIndex alice = graph.addNode(Name("/ndn/ucla/alice"));
+  TrustGraph::NodeIndex bob = graph.addNode(Name("/ndn/ucla/bob"));
+  graph.addEdge(alice, bob);
+  graph.addEdge(bob, alice);
+  graph.finalize();
+
+  graph.computeLevels();
+  BOOST_CHECK_EQUAL(graph.getLevel(alice), 0);
+  BOOST_CHECK_EQUAL(graph.getLevel(bob), 1);
+}
+
+BOOST_AUTO_TEST_CASE(MultipleLevelLayout)
+{
+  TrustGraph graph;
+  TrustGraph::NodeIndex root = graph.addNode(Name("/ndn"));
+  TrustGraph::NodeIndex alice = graph.addNode(Name("/ndn/alice"));
+  TrustGraph::NodeIndex bob = graph.addNode(Name("/ndn/bob"));
+  graph.addEdge(root, alice);
+  graph.addEdge(root, bob);
+  graph.finalize();
+  graph.computeLevels();
+
+  MultipleLevelTreeLayout layout;
+  layout.setSiblingDistance(100);
+  layout.setLevelDistance(50);
+  layout.setMultipleLevelTreeLayout(graph);
+
+  BOOST_CHECK_EQUAL(graph.getX(root), 0);
+  BOOST_CHECK_EQUAL(graph.getY(root), 0);
+  BOOST_CHECK_EQUAL(graph.getX(alice), -50);
+  BOOST_CHECK_EQUAL(graph.getX(bob), 50);
+  BOOST_CHECK_EQUAL(graph.getY(bob), 50);
+}
+
+BOOST_AUTO_TEST_CASE(LayeredLayoutCrossing)
+{
+  TrustGraph graph;
+  TrustGraph::NodeIndex a = graph.addNode(Name("/ndn/a"));
+  TrustGraph::NodeIndex b = graph.addNode(Name("/ndn/b"));
+  TrustGraph::NodeIndex c = graph.addNode(Name("/ndn/c"));
+  TrustGraph::NodeIndex d = graph.addNode(Name("/ndn/d"));
+  // in insertion order, b->c and a->d cross
+  graph.addEdge(b, c);
+  graph.addEdge(a, d);
+  graph.finalize();
+  graph.computeLevels();
+
+  LayeredTreeLayout layout;
+  layout.setSiblingDistance(100);
+  layout.setLevelDistance(100);
+  layout.setLayeredTreeLayout(graph);
+
+  BOOST_CHECK_LT(graph.getX(a), graph.getX(b));
+  BOOST_CHECK_LT(graph.getX(d), graph.getX(c));
+  BOOST_CHECK_EQUAL(graph.getX(d), -50);
+  BOOST_CHECK_EQUAL(graph.getY(d), 100);
+}
+
+BOOST_AUTO_TEST_CASE(LayeredLayoutIncremental)
+{
+  TrustGraph graph;
+  TrustGraph::NodeIndex root = graph.addNode(Name("/ndn"));
+  TrustGraph::NodeIndex ucla = graph.addNode(Name("/ndn/ucla"));
+  TrustGraph::NodeIndex mit = graph.addNode(Name("/ndn/mit"));
+  TrustGraph::NodeIndex alice = graph.addNode(Name("/ndn/ucla/alice"));
+  graph.addEdge(root, ucla);
+  graph.addEdge(root, mit);
+  graph.addEdge(ucla, alice);
+  graph.finalize();
+  graph.computeLevels();
+
+  LayeredTreeLayout layout;
+  layout.setSiblingDistance(100);
+  layout.setLevelDistance(100);
+  layout.setLayeredTreeLayout(graph);
+  BOOST_CHECK_EQUAL(layout.getRelayoutLayerCount(), 3);
+
+  double uclaX = graph.getX(ucla);
+
+  // nothing changed
+  layout.setLayeredTreeLayout(graph);
+  BOOST_CHECK_EQUAL(layout.getRelayoutLayerCount(), 0);
+  BOOST_CHECK_EQUAL(graph.getX(ucla), uclaX);
+
+  // a new contact introduced by mit only touches the bottom two layers
+  TrustGraph::NodeIndex bob = graph.addNode(Name("/ndn/mit/bob"));
+  graph.addEdge(mit, bob);
+  graph.finalize();
+  graph.computeLevels();
+
+  layout.setLayeredTreeLayout(graph);
+  BOOST_CHECK_EQUAL(layout.getRelayoutLayerCount(), 2);
+  BOOST_CHECK_EQUAL(graph.getX(ucla), uclaX);
+  BOOST_CHECK_LT(graph.getX(alice), graph.getX(bob));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace chronochat
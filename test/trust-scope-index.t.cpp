@@ -0,0 +1,72 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2013, Regents of the University of California
+ *
+ * BSD license, See the LICENSE file for more information
+ *
+ * Author: Yingdi Yu <yingdi@cs.ucla.edu>
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "trust-scope-index.hpp"
+
+namespace chronochat {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(TestTrustScopeIndex)
+
+BOOST_AUTO_TEST_CASE(FindIntroducers)
+{
+  TrustScopeIndex index;
+  index.insert(Name("/alice"), Name("/ndn/ucla"));
+  index.insert(Name("/bob"), Name("/ndn"));
+  index.insert(Name("/bob"), Name("/ndn/ucla/cs"));
+  index.insert(Name("/carol"), Name("/ndn/ucla/cs/yingdi"));
+  index.insert(Name("/dave"), Name("/ndn/arizona"));
+  BOOST_CHECK_EQUAL(index.size(), 5);
+
+  TrustScopeIndex::Introducers introducers = index.findIntroducers(Name("/ndn/ucla/cs/qiuhan"));
+  BOOST_CHECK_EQUAL(introducers.size(), 2);
+  BOOST_CHECK_EQUAL(introducers.count(Name("/alice")), 1);
+  BOOST_CHECK_EQUAL(introducers.count(Name("/bob")), 1);
+
+  BOOST_CHECK(index.canBeTrustedFor(Name("/carol"), Name("/ndn/ucla/cs/yingdi")));
+  BOOST_CHECK(!index.canBeTrustedFor(Name("/carol"), Name("/ndn/ucla/cs")));
+  BOOST_CHECK(!index.canBeTrustedFor(Name("/dave"), Name("/ndn/ucla")));
+  BOOST_CHECK(!index.canBeTrustedFor(Name("/eve"), Name("/ndn/ucla")));
+
+  // a scope matches whole components only
+  BOOST_CHECK(!index.canBeTrustedFor(Name("/alice"), Name("/ndn/uclax")));
+
+  // the root scope covers every name
+  index.insert(Name("/eve"), Name("/"));
+  BOOST_CHECK(index.canBeTrustedFor(Name("/eve"), Name("/any/name")));
+  BOOST_CHECK(index.canBeTrustedFor(Name("/eve"), Name("/")));
+}
+
+BOOST_AUTO_TEST_CASE(Erase)
+{
+  TrustScopeIndex index;
+  index.insert(Name("/alice"), Name("/ndn/ucla"));
+  index.insert(Name("/bob"), Name("/ndn/ucla/cs"));
+  index.insert(Name("/bob"), Name("/ndn/arizona"));
+
+  index.erase(Name("/bob"));
+  BOOST_CHECK_EQUAL(index.size(), 1);
+  BOOST_CHECK(!index.canBeTrustedFor(Name("/bob"), Name("/ndn/ucla/cs")));
+  BOOST_CHECK(!index.canBeTrustedFor(Name("/bob"), Name("/ndn/arizona")));
+  BOOST_CHECK(index.canBeTrustedFor(Name("/alice"), Name("/ndn/ucla/cs")));
+
+  index.erase(Name("/alice"));
+  BOOST_CHECK_EQUAL(index.size(), 0);
+  BOOST_CHECK(index.findIntroducers(Name("/ndn/ucla/cs")).empty());
+
+  index.insert(Name("/alice"), Name("/ndn/ucla"));
+  BOOST_CHECK(index.canBeTrustedFor(Name("/alice"), Name("/ndn/ucla")));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace chronochat